@@ -0,0 +1,265 @@
+#include <QtCore/qglobal.h>
+#include <QElapsedTimer>
+
+#include "qmpu6050decoder.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+/*
+ * Decodes the same block of FIFO packets with the original per-axis decode
+ * and with every decoder kernel the CPU supports, checks every kernel against
+ * both the original decode and the scalar kernel and prints the time per
+ * packet. The kernels also fill the raw arrays and the temperature, which
+ * the original decode did not. Usage: qmpu6050decoderbenchmark [packets]
+ * [iterations]
+ */
+
+namespace {
+
+//the original decode converts to qreal and truncates the rotation to whole
+//degrees/s, the kernels multiply in float
+const qreal accelerationTolerance = 1e-6;
+const qreal rotationTolerance = 1;
+
+const int accelerationChannels[] = { QMPU6050Decoder::AccelerationX, QMPU6050Decoder::AccelerationY, QMPU6050Decoder::AccelerationZ };
+const int rotationChannels[] = { QMPU6050Decoder::RotationX, QMPU6050Decoder::RotationY, QMPU6050Decoder::RotationZ };
+
+//accelerometer and gyroscope in g and degrees/s, decoded axis by axis the
+//way QMPU6050Backend::get6AxisMotion() did before the block decoder
+struct Original
+{
+    std::vector<qreal> acceleration[3];
+    std::vector<qreal> rotation[3];
+
+    explicit Original(qsizetype count)
+    {
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            acceleration[axis].assign(count, 0);
+            rotation[axis].assign(count, 0);
+        }
+    }
+
+    void decode(const quint8 *packets, qsizetype count, quint16 packetSize)
+    {
+        //the gyroscope follows the temperature in 14 byte packets
+        const int rotationOffset = packetSize == 14 ? 8 : 6;
+
+        for(qsizetype i = 0; i < count; ++i)
+        {
+            const quint8 *buffer = packets + i * packetSize;
+
+            for(int axis = 0; axis < 3; ++axis)
+            {
+                qreal value = ((((qint16)buffer[2 * axis]) << 8) | buffer[2 * axis + 1]);
+
+                if(value > 32768)
+                    value = (value - 65536) / 16384.0;
+                else
+                    value /= 16384.0;
+
+                acceleration[axis][i] = value;
+            }
+
+            for(int axis = 0; axis < 3; ++axis)
+                rotation[axis][i] = ((((qint16)buffer[rotationOffset + 2 * axis]) << 8) | buffer[rotationOffset + 2 * axis + 1]) / 131;
+        }
+    }
+};
+
+//compares a kernel in native units against the original decode; words the
+//original got wrong (0x8000 acceleration is not wrapped, negative rotation
+//is not sign-extended) are counted as defects, not as mismatches
+struct Comparison
+{
+    qsizetype mismatches = 0;
+    qsizetype defects = 0;
+};
+
+struct Result
+{
+    std::vector<float> values[QMPU6050Decoder::ChannelCount];
+    std::vector<qint16> raw[QMPU6050Decoder::ChannelCount];
+
+    explicit Result(qsizetype count)
+    {
+        for(int channel = 0; channel < QMPU6050Decoder::ChannelCount; ++channel)
+        {
+            values[channel].assign(count, 0);
+            raw[channel].assign(count, 0);
+        }
+    }
+
+    QMPU6050Decoder::Output output()
+    {
+        QMPU6050Decoder::Output output;
+
+        for(int channel = 0; channel < QMPU6050Decoder::ChannelCount; ++channel)
+        {
+            output.values[channel] = values[channel].data();
+            output.raw[channel] = raw[channel].data();
+        }
+
+        return output;
+    }
+
+    bool operator==(const Result &other) const
+    {
+        for(int channel = 0; channel < QMPU6050Decoder::ChannelCount; ++channel)
+        {
+            if(values[channel] != other.values[channel] || raw[channel] != other.raw[channel])
+                return false;
+        }
+
+        return true;
+    }
+};
+
+Comparison compare(const Result &result, const Original &original, qsizetype count)
+{
+    Comparison comparison;
+
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        const int acceleration = accelerationChannels[axis];
+        const int rotation = rotationChannels[axis];
+
+        for(qsizetype i = 0; i < count; ++i)
+        {
+            if(result.raw[acceleration][i] == -32768)
+                ++comparison.defects;
+            else if(qAbs(result.values[acceleration][i] - original.acceleration[axis][i]) > accelerationTolerance)
+                ++comparison.mismatches;
+
+            if(result.raw[rotation][i] < 0)
+                ++comparison.defects;
+            else if(qAbs(result.values[rotation][i] - original.rotation[axis][i]) >= rotationTolerance)
+                ++comparison.mismatches;
+        }
+    }
+
+    return comparison;
+}
+
+qreal nanosecondsPerPacket(qint64 elapsed, qsizetype count, int iterations)
+{
+    return static_cast<qreal>(elapsed) / (static_cast<qreal>(count) * iterations);
+}
+
+const char *name(QMPU6050Decoder::Implementation implementation)
+{
+    switch(implementation)
+    {
+    case QMPU6050Decoder::ScalarImplementation:
+        return "scalar";
+    case QMPU6050Decoder::SSSE3Implementation:
+        return "ssse3";
+    case QMPU6050Decoder::AVX2Implementation:
+        return "avx2";
+    case QMPU6050Decoder::NEONImplementation:
+        return "neon";
+    }
+
+    return "unknown";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    qsizetype count = argc > 1 ? atoi(argv[1]) : 1024;
+    int iterations = argc > 2 ? atoi(argv[2]) : 2000;
+
+    if(count <= 0 || iterations <= 0)
+    {
+        fprintf(stderr, "usage: %s [packets] [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    const QMPU6050Decoder::Implementation implementations[] =
+    {
+        QMPU6050Decoder::ScalarImplementation,
+        QMPU6050Decoder::SSSE3Implementation,
+        QMPU6050Decoder::AVX2Implementation,
+        QMPU6050Decoder::NEONImplementation
+    };
+
+    //the original decode hard-coded the power-on ranges and native units
+    const QMPU6050Decoder::Scale *scale = QMPU6050Decoder::nativeScale(0, 0);
+    const QMPU6050Decoder::Implementation selected = QMPU6050Decoder::implementation();
+    int status = 0;
+
+    std::mt19937 generator(6050);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    for(quint16 packetSize : { quint16(12), quint16(14) })
+    {
+        std::vector<quint8> packets(count * packetSize);
+
+        for(quint8 &value : packets)
+            value = static_cast<quint8>(byte(generator));
+
+        Result reference(count);
+        QMPU6050Decoder::setImplementation(QMPU6050Decoder::ScalarImplementation);
+
+        QMPU6050Decoder::Output output = reference.output();
+        QMPU6050Decoder::decode(packets.data(), count, packetSize, *scale, &output);
+
+        printf("%d byte packets, %lld per block, %d blocks\n", packetSize, static_cast<long long>(count), iterations);
+
+        Original original(count);
+        original.decode(packets.data(), count, packetSize);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        for(int i = 0; i < iterations; ++i)
+            original.decode(packets.data(), count, packetSize);
+
+        const qreal baseline = nanosecondsPerPacket(timer.nsecsElapsed(), count, iterations);
+        printf("  %-8s %8.2f ns/packet\n", "original", baseline);
+
+        for(QMPU6050Decoder::Implementation implementation : implementations)
+        {
+            if(!QMPU6050Decoder::isAvailable(implementation) || !QMPU6050Decoder::setImplementation(implementation))
+            {
+                printf("  %-8s not available\n", name(implementation));
+                continue;
+            }
+
+            Result result(count);
+            output = result.output();
+
+            //warm up the caches and the branch predictors before timing
+            QMPU6050Decoder::decode(packets.data(), count, packetSize, *scale, &output);
+
+            timer.restart();
+
+            for(int i = 0; i < iterations; ++i)
+                QMPU6050Decoder::decode(packets.data(), count, packetSize, *scale, &output);
+
+            const qreal elapsed = nanosecondsPerPacket(timer.nsecsElapsed(), count, iterations);
+            const bool matches = result == reference;
+            const Comparison comparison = compare(result, original, count);
+
+            if(!matches || comparison.mismatches)
+                status = 1;
+
+            printf("  %-8s %8.2f ns/packet %6.2fx, %lld outside tolerance of original, %lld original defects %s\n",
+                   name(implementation),
+                   elapsed,
+                   baseline / elapsed,
+                   static_cast<long long>(comparison.mismatches),
+                   static_cast<long long>(comparison.defects),
+                   matches ? "" : "MISMATCH WITH SCALAR");
+        }
+    }
+
+    QMPU6050Decoder::setImplementation(selected);
+
+    return status;
+}
@@ -0,0 +1,191 @@
+#ifndef QBROADCASTRING_H
+#define QBROADCASTRING_H
+
+#include <QtCore/qglobal.h>
+#include <QAtomicInteger>
+#include "qmpu6050_global.h"
+
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Lock-free single writer, multi reader ring of fixed capacity
+ *
+ * The writer publishes every value once and never waits for readers; the
+ * oldest value is overwritten when the ring is full. Each reader owns a
+ * Reader cursor and consumes the stream at its own pace.
+ *
+ * Every slot carries a sequence number that is odd while the writer updates
+ * it, so readers can look at a slot in place through peek() and confirm with
+ * release() that it was not overwritten while they used it. A reader that
+ * falls more than Capacity values behind is lapped: its cursor jumps to the
+ * oldest value still in the ring and the skipped values are added to
+ * Reader::lostCount().
+ *
+ * Capacity must be a power of two.
+ */
+template<typename T, quint32 Capacity>
+class QBroadcastRing
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "QBroadcastRing capacity must be a power of two");
+
+public:
+    class Reader
+    {
+    public:
+        quint64 position() const
+        {
+            return m_next;
+        }
+
+        quint64 lostCount() const
+        {
+            return m_lost;
+        }
+
+    private:
+        friend class QBroadcastRing;
+
+        quint64 m_next = 0;
+        quint64 m_lost = 0;
+    };
+
+    //writer side, one thread only
+    void publish(const T &value)
+    {
+        const quint64 index = m_head.loadRelaxed();
+        Slot &slot = m_slots[index & (Capacity - 1)];
+
+        slot.sequence.storeRelaxed(index * 2 + 1);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.value = value;
+
+        slot.sequence.storeRelease(index * 2 + 2);
+        m_head.storeRelease(index + 1);
+    }
+
+    //cursor starting with the next value published
+    Reader reader() const
+    {
+        Reader reader;
+        reader.m_next = m_head.loadAcquire();
+
+        return reader;
+    }
+
+    //cursor starting with the oldest value still in the ring
+    Reader oldestReader() const
+    {
+        const quint64 head = m_head.loadAcquire();
+
+        Reader reader;
+        reader.m_next = head > Capacity ? head - Capacity : 0;
+
+        return reader;
+    }
+
+    /*!
+     * Returns the value at the reader's cursor without copying it, or nullptr
+     * if the reader is caught up. The pointer stays valid until release(),
+     * which tells whether the writer overwrote it in the meantime.
+     */
+    const T *peek(Reader *reader) const
+    {
+        while(true)
+        {
+            const quint64 head = m_head.loadAcquire();
+
+            if(reader->m_next >= head)
+                return nullptr;
+
+            skipLapped(reader, head);
+
+            const Slot &slot = m_slots[reader->m_next & (Capacity - 1)];
+
+            if(slot.sequence.loadAcquire() == reader->m_next * 2 + 2)
+                return &slot.value;
+
+            //overwritten between reading head and the slot, catch up and retry
+            skipLapped(reader, m_head.loadAcquire() + 1);
+        }
+    }
+
+    /*!
+     * Advances the reader past the value returned by peek(). Returns false if
+     * the value was overwritten while it was in use; it must then be
+     * discarded and is counted as lost.
+     */
+    bool release(Reader *reader) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        const Slot &slot = m_slots[reader->m_next & (Capacity - 1)];
+        const bool intact = slot.sequence.loadRelaxed() == reader->m_next * 2 + 2;
+
+        if(!intact)
+            ++reader->m_lost;
+
+        ++reader->m_next;
+
+        return intact;
+    }
+
+    //copying convenience around peek() and release()
+    bool read(Reader *reader, T *value) const
+    {
+        while(const T *current = peek(reader))
+        {
+            *value = *current;
+
+            if(release(reader))
+                return true;
+        }
+
+        return false;
+    }
+
+    //values published but not yet consumed by reader, lapped values included
+    quint64 available(const Reader &reader) const
+    {
+        const quint64 head = m_head.loadAcquire();
+
+        return head > reader.m_next ? head - reader.m_next : 0;
+    }
+
+    quint64 publishedCount() const
+    {
+        return m_head.loadAcquire();
+    }
+
+    static constexpr quint32 capacity()
+    {
+        return Capacity;
+    }
+
+private:
+    struct Slot
+    {
+        QAtomicInteger<quint64> sequence = 0;
+        T value;
+    };
+
+    void skipLapped(Reader *reader, quint64 head) const
+    {
+        if(head - reader->m_next <= Capacity)
+            return;
+
+        const quint64 oldest = head - Capacity;
+
+        reader->m_lost += oldest - reader->m_next;
+        reader->m_next = oldest;
+    }
+
+    QAtomicInteger<quint64> m_head = 0;
+    Slot m_slots[Capacity];
+};
+
+QT_END_NAMESPACE
+
+#endif // QBROADCASTRING_H
@@ -0,0 +1,109 @@
+#include "qeventfdinterruptsource.h"
+#include "qi2ctransport.h"
+
+#include <unistd.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+
+QEventFdInterruptSource::~QEventFdInterruptSource()
+{
+    close();
+}
+
+bool QEventFdInterruptSource::open()
+{
+    if(m_fd >= 0)
+        return true;
+
+    m_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    return m_fd >= 0;
+}
+
+void QEventFdInterruptSource::close()
+{
+    if(m_fd < 0)
+        return;
+
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+bool QEventFdInterruptSource::isOpen() const
+{
+    return m_fd >= 0;
+}
+
+int QEventFdInterruptSource::handle() const
+{
+    return m_fd;
+}
+
+int QEventFdInterruptSource::read(Event *events, int maximum)
+{
+    quint64 counter = 0;
+
+    if(::read(m_fd, &counter, sizeof(counter)) < 0 && errno != EAGAIN)
+        return -1;
+
+    QMutexLocker locker(&m_mutex);
+
+    m_pending += counter;
+
+    int count = static_cast<int>(qMin<quint64>(m_pending, static_cast<quint64>(qMax(0, maximum))));
+    quint64 now = QI2CTransport::timestamp();
+
+    //the oldest pending events are the ones with a stored timestamp
+    for(int i = 0; i < count; ++i)
+    {
+        if(m_count > 0)
+        {
+            events[i].timestamp = m_timestamps[m_head];
+            m_head = (m_head + 1) % eventCapacity;
+            --m_count;
+        }
+        else
+            events[i].timestamp = now;
+
+        events[i].sequence = ++m_sequence;
+    }
+
+    m_pending -= count;
+
+    //keep the fd readable for what is left, the counter is folded back in
+    //by the next read
+    if(m_pending > 0)
+    {
+        quint64 one = 1;
+        ::write(m_fd, &one, sizeof(one));
+        --m_pending;
+    }
+
+    return count;
+}
+
+/*!
+ * Raises one event stamped \a timestamp ns on CLOCK_MONOTONIC, or now if it
+ * is 0. May be called from any thread.
+ */
+bool QEventFdInterruptSource::trigger(quint64 timestamp)
+{
+    if(m_fd < 0)
+    {
+        errno = EBADF;
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if(m_count < eventCapacity)
+        {
+            m_timestamps[(m_head + m_count) % eventCapacity] = timestamp ? timestamp : QI2CTransport::timestamp();
+            ++m_count;
+        }
+    }
+
+    quint64 one = 1;
+    return ::write(m_fd, &one, sizeof(one)) == sizeof(one);
+}
@@ -0,0 +1,50 @@
+#ifndef QEVENTFDINTERRUPTSOURCE_H
+#define QEVENTFDINTERRUPTSOURCE_H
+
+#include <QMutex>
+#include "qmpu6050_global.h"
+#include "qinterruptsource.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Software interrupt source backed by an eventfd
+ *
+ * Stands in for a GPIO line where there is none: every trigger() queues an
+ * event and makes handle() readable, from any thread. Up to eventCapacity
+ * timestamps are kept; events beyond that are still counted and reported
+ * with the time they were read.
+ */
+class QMPU6_5__EXPORT QEventFdInterruptSource : public QInterruptSource
+{
+    Q_DISABLE_COPY(QEventFdInterruptSource)
+public:
+    static constexpr int eventCapacity = 64;
+
+    QEventFdInterruptSource() = default;
+    ~QEventFdInterruptSource();
+
+    virtual bool open() override;
+    virtual void close() override;
+    virtual bool isOpen() const override;
+
+    virtual int handle() const override;
+    virtual int read(Event *events, int maximum) override;
+
+    bool trigger(quint64 timestamp = 0);
+
+private:
+    int m_fd = -1;
+
+    QMutex m_mutex;
+    quint64 m_timestamps[eventCapacity];
+    int m_head = 0;
+    int m_count = 0;
+
+    //events counted by the eventfd but not yet handed out
+    quint64 m_pending = 0;
+    quint32 m_sequence = 0;
+};
+
+QT_END_NAMESPACE
+#endif // QEVENTFDINTERRUPTSOURCE_H
@@ -0,0 +1,159 @@
+#include "qgpiointerruptsource.h"
+
+#include <QDebug>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/ioctl.h>
+
+#ifdef Q_OS_LINUX
+#include <linux/gpio.h>
+#endif
+
+QGPIOInterruptSource::QGPIOInterruptSource(const QString &chip, quint32 line, bool activeLow)
+{
+    m_chip = chip;
+    m_line = line;
+    m_activeLow = activeLow;
+}
+
+QGPIOInterruptSource::~QGPIOInterruptSource()
+{
+    close();
+}
+
+bool QGPIOInterruptSource::open()
+{
+#ifdef Q_OS_LINUX
+    if(m_fd >= 0)
+        return true;
+
+    int chip = ::open(m_chip.toStdString().c_str(), O_RDONLY | O_CLOEXEC);
+
+    if(chip < 0)
+    {
+        qDebug() << QString("COULD NOT OPEN GPIO CHIP %1: %2").arg(m_chip, strerror(errno));
+        return false;
+    }
+
+    struct gpio_v2_line_request request;
+    memset(&request, 0, sizeof(request));
+
+    request.offsets[0] = m_line;
+    request.num_lines = 1;
+    strncpy(request.consumer, "qmpu6050", sizeof(request.consumer) - 1);
+
+    //edges are logical, with ACTIVE_LOW the falling pin edge reports as rising
+    request.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING;
+
+    if(m_activeLow)
+        request.config.flags |= GPIO_V2_LINE_FLAG_ACTIVE_LOW;
+
+    int result = ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &request);
+    int error = errno;
+
+    ::close(chip);
+
+    if(result < 0)
+    {
+        qDebug() << QString("COULD NOT REQUEST GPIO LINE %1 OF %2: %3").arg(m_line).arg(m_chip, strerror(error));
+        errno = error;
+        return false;
+    }
+
+    m_fd = request.fd;
+    fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+
+    return true;
+#else
+    errno = ENOSYS;
+    return false;
+#endif
+}
+
+void QGPIOInterruptSource::close()
+{
+    if(m_fd < 0)
+        return;
+
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+bool QGPIOInterruptSource::isOpen() const
+{
+    return m_fd >= 0;
+}
+
+int QGPIOInterruptSource::handle() const
+{
+    return m_fd;
+}
+
+/*!
+ * Takes up to \a maximum queued edges without blocking. Returns 0 if none
+ * is pending.
+ */
+int QGPIOInterruptSource::read(Event *events, int maximum)
+{
+#ifdef Q_OS_LINUX
+    struct gpio_v2_line_event buffer[16];
+
+    ssize_t size = ::read(m_fd, buffer, sizeof(struct gpio_v2_line_event) * qBound(1, maximum, 16));
+
+    if(size < 0)
+        return errno == EAGAIN ? 0 : -1;
+
+    int count = static_cast<int>(size / sizeof(struct gpio_v2_line_event));
+
+    for(int i = 0; i < count; ++i)
+    {
+        events[i].timestamp = buffer[i].timestamp_ns;
+        events[i].sequence = buffer[i].line_seqno;
+    }
+
+    return count;
+#else
+    Q_UNUSED(events)
+    Q_UNUSED(maximum)
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+QString QGPIOInterruptSource::chip() const
+{
+    return m_chip;
+}
+
+quint32 QGPIOInterruptSource::line() const
+{
+    return m_line;
+}
+
+/*!
+ * Creates a source from "<chip>:<line>", e.g. "gpiochip0:17" or
+ * "/dev/gpiochip0:17". Returns nullptr if \a specification is malformed.
+ */
+QGPIOInterruptSource *QGPIOInterruptSource::fromString(const QString &specification, bool activeLow)
+{
+    qsizetype separator = specification.lastIndexOf(QLatin1Char(':'));
+
+    if(separator <= 0)
+        return nullptr;
+
+    bool ok = false;
+    quint32 line = specification.mid(separator + 1).toUInt(&ok);
+
+    if(!ok)
+        return nullptr;
+
+    QString chip = specification.left(separator);
+
+    if(!chip.startsWith(QLatin1Char('/')))
+        chip.prepend(QStringLiteral("/dev/"));
+
+    return new QGPIOInterruptSource(chip, line, activeLow);
+}
@@ -0,0 +1,47 @@
+#ifndef QGPIOINTERRUPTSOURCE_H
+#define QGPIOINTERRUPTSOURCE_H
+
+#include <QString>
+#include "qmpu6050_global.h"
+#include "qinterruptsource.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Interrupt line read through the Linux GPIO character device
+ *
+ * Requests one line of a gpiochip as an input with edge detection using the
+ * v2 uAPI (GPIO_V2_GET_LINE_IOCTL). The kernel stamps every edge with
+ * CLOCK_MONOTONIC and queues it on the line request fd.
+ *
+ * The MPU6050 INT pin is configured active high, so the rising edge marks
+ * new data. Set \a activeLow for boards that invert the line.
+ */
+class QMPU6_5__EXPORT QGPIOInterruptSource : public QInterruptSource
+{
+    Q_DISABLE_COPY(QGPIOInterruptSource)
+public:
+    QGPIOInterruptSource(const QString &chip, quint32 line, bool activeLow = false);
+    ~QGPIOInterruptSource();
+
+    virtual bool open() override;
+    virtual void close() override;
+    virtual bool isOpen() const override;
+
+    virtual int handle() const override;
+    virtual int read(Event *events, int maximum) override;
+
+    QString chip() const;
+    quint32 line() const;
+
+    static QGPIOInterruptSource *fromString(const QString &specification, bool activeLow = false);
+
+private:
+    QString m_chip;
+    quint32 m_line = 0;
+    bool m_activeLow = false;
+    int m_fd = -1;
+};
+
+QT_END_NAMESPACE
+#endif // QGPIOINTERRUPTSOURCE_H
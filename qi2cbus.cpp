@@ -0,0 +1,235 @@
+#include "qi2cbus.h"
+
+#include <errno.h>
+
+//registry of open buses keyed by device path
+static QMutex registryMutex;
+static QHash<QString, QI2CBus*> registry;
+
+QI2CBus::QI2CBus(const QString &path)
+{
+    m_path = path;
+    m_transport = QI2CTransport::create(path);
+}
+
+QI2CBus::~QI2CBus()
+{
+    close();
+
+    delete m_transport;
+    qDeleteAll(m_shadows);
+    qDeleteAll(m_statistics);
+}
+
+QI2CBus *QI2CBus::acquire(const QString &path)
+{
+    QMutexLocker locker(&registryMutex);
+
+    QI2CBus *bus = registry.value(path, nullptr);
+
+    if(!bus)
+    {
+        bus = new QI2CBus(path);
+        registry.insert(path, bus);
+    }
+
+    ++bus->m_refCount;
+
+    return bus;
+}
+
+void QI2CBus::release(QI2CBus *bus)
+{
+    if(!bus)
+        return;
+
+    QMutexLocker locker(&registryMutex);
+
+    if(--bus->m_refCount > 0)
+        return;
+
+    registry.remove(bus->m_path);
+    delete bus;
+}
+
+/*!
+ * Returns the register shadow of the device at \a address, creating an empty
+ * one on first use. Access it with mutex() held.
+ */
+QI2CRegisterShadow *QI2CBus::shadow(quint16 address)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QI2CRegisterShadow *shadow = m_shadows.value(address, nullptr);
+
+    if(!shadow)
+    {
+        shadow = new QI2CRegisterShadow;
+        m_shadows.insert(address, shadow);
+    }
+
+    return shadow;
+}
+
+/*!
+ * Returns the traffic counters of the device at \a address, creating them on
+ * first use. Access them with mutex() held.
+ */
+QI2CStatistics *QI2CBus::statistics(quint16 address)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QI2CStatistics *statistics = m_statistics.value(address, nullptr);
+
+    if(!statistics)
+    {
+        statistics = new QI2CStatistics;
+        m_statistics.insert(address, statistics);
+    }
+
+    return statistics;
+}
+
+QString QI2CBus::path() const
+{
+    return m_path;
+}
+
+qint32 QI2CBus::refCount() const
+{
+    QMutexLocker locker(&registryMutex);
+    return m_refCount;
+}
+
+bool QI2CBus::open()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(m_transport->isOpen())
+        return true;
+
+    if(!m_transport->open())
+    {
+        m_errno = errno;
+        return false;
+    }
+
+    ++m_openCount;
+
+    return true;
+}
+
+bool QI2CBus::close()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(!m_transport->isOpen())
+        return true;
+
+    ++m_closeCount;
+
+    if(!m_transport->close())
+    {
+        m_errno = errno;
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+ * Drops the transport after a transfer failed with \a error, but only when
+ * the error concerns the adapter itself. A NACK or timeout of one slave
+ * leaves the bus open for every other device on it. EIO is not taken as an
+ * adapter error, several adapter drivers report single slave failures with
+ * it.
+ */
+bool QI2CBus::invalidate(int error)
+{
+    switch(error)
+    {
+    case EBADF:
+    case ENODEV:
+        return close();
+    default:
+        return true;
+    }
+}
+
+bool QI2CBus::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_transport->isOpen();
+}
+
+/*!
+ * Checks that \a address can be claimed on this adapter. Transfers carry
+ * the slave address in every message, so the binding itself is only used
+ * to detect addresses owned by a kernel driver.
+ */
+bool QI2CBus::bind(quint16 address)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(!m_transport->isOpen() && !open())
+        return false;
+
+    if(!m_transport->bind(address))
+    {
+        m_errno = errno;
+        return false;
+    }
+
+    return true;
+}
+
+bool QI2CBus::transfer(struct i2c_msg *messages, quint32 count)
+{
+    QMutexLocker locker(&m_mutex);
+
+    //the transport is dropped after errors, reopen it lazily
+    if(!m_transport->isOpen() && !open())
+    {
+        errno = m_errno;
+        return false;
+    }
+
+    if(!m_transport->transfer(messages, count))
+    {
+        m_errno = errno;
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+ * Returns the transport carrying this bus. Use it with mutex() held.
+ */
+QI2CTransport *QI2CBus::transport()
+{
+    return m_transport;
+}
+
+QRecursiveMutex *QI2CBus::mutex()
+{
+    return &m_mutex;
+}
+
+quint64 QI2CBus::openCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_openCount;
+}
+
+quint64 QI2CBus::closeCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_closeCount;
+}
+
+int QI2CBus::error() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_errno;
+}
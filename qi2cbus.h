@@ -0,0 +1,77 @@
+#ifndef QI2CBUS_H
+#define QI2CBUS_H
+
+#include <QObject>
+#include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QRecursiveMutex>
+#include "qmpu6050_global.h"
+#include "qi2cregistershadow.h"
+#include "qi2ctransport.h"
+#include "qi2cstatistics.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Process-wide handle to an I2C adapter
+ *
+ * Every QI2CDevice that talks to the same bus path shares a single QI2CBus
+ * and therefore a single transport. Buses are reference counted and handed
+ * out by acquire(); the transport is closed once the last reference is
+ * released. The transport is picked by QI2CTransport::create() from the bus
+ * path, so "/dev/i2c-1" goes through i2c-dev while registered prefixes such
+ * as "emulator:" are served in process.
+ *
+ * All transfers are serialized on the bus mutex so several sensors and
+ * threads can use the same adapter. Read-modify-write sequences that must
+ * not be interleaved should hold mutex() for their whole duration.
+ */
+class QMPU6_5__EXPORT QI2CBus
+{
+    Q_DISABLE_COPY(QI2CBus)
+public:
+    static QI2CBus *acquire(const QString &path);
+    static void release(QI2CBus *bus);
+
+    QString path() const;
+    qint32 refCount() const;
+
+    bool open();
+    bool close();
+    bool isOpen() const;
+    bool invalidate(int error);
+
+    bool bind(quint16 address);
+    bool transfer(struct i2c_msg *messages, quint32 count);
+
+    QRecursiveMutex *mutex();
+
+    QI2CRegisterShadow *shadow(quint16 address);
+    QI2CTransport *transport();
+    QI2CStatistics *statistics(quint16 address);
+
+    quint64 openCount() const;
+    quint64 closeCount() const;
+    int error() const;
+
+private:
+    explicit QI2CBus(const QString &path);
+    ~QI2CBus();
+
+    QString m_path;
+    QI2CTransport *m_transport = nullptr;
+    int m_errno = 0;
+    qint32 m_refCount = 0;
+    quint64 m_openCount = 0;
+    quint64 m_closeCount = 0;
+
+    mutable QRecursiveMutex m_mutex;
+
+    //register shadows keyed by device address, outlive fd reopens
+    QHash<quint16, QI2CRegisterShadow*> m_shadows;
+    QHash<quint16, QI2CStatistics*> m_statistics;
+};
+
+QT_END_NAMESPACE
+#endif // QI2CBUS_H
@@ -14,9 +14,17 @@ QI2CDevice::QI2CDevice(const QString &bus, const quint16 address)
     m_bus = bus;
 }
 
+QI2CDevice::~QI2CDevice()
+{
+    close();
+}
+
 bool QI2CDevice::read(quint8 registerAddress, quint8 *buffer, quint16 length)
 {
 #ifdef Q_OS_LINUX
+    if(!m_handle && m_persistent && !start())
+        return false;
+
     struct i2c_msg messages[]
     {
         {
@@ -33,19 +41,20 @@ bool QI2CDevice::read(quint8 registerAddress, quint8 *buffer, quint16 length)
         }
     };
 
-    struct i2c_rdwr_ioctl_data payload =
-    {
-        .msgs = messages,
-        .nmsgs = 2
-    };
+    //keep the transfer and the shadow update atomic against other devices
+    QMutexLocker locker(m_handle ? m_handle->mutex() : nullptr);
 
-    if(ioctl(m_i2c, I2C_RDWR, &payload) < 0)
+    if(!transfer(messages, 2, QI2CStatistics::ReadOperation))
     {
         qDebug() << QString("COULD NOT READ REGISTER 0x%1").arg(registerAddress, 2, 16, '0');
         m_errno = errno;
+        invalidate();
         return false;
     }
 
+    if(QI2CRegisterShadow *registers = currentShadow())
+        registers->store(registerAddress, buffer, length);
+
     return true;
 #else
     return false;
@@ -55,7 +64,10 @@ bool QI2CDevice::read(quint8 registerAddress, quint8 *buffer, quint16 length)
 bool QI2CDevice::read(quint16 registerAddress, quint8 *buffer, quint16 length)
 {
 #ifdef Q_OS_LINUX
-    quint8 *registerBuffer = new quint8[2]
+    if(!m_handle && m_persistent && !start())
+        return false;
+
+    quint8 registerBuffer[2]
     {
         static_cast<quint8>(registerAddress),
         static_cast<quint8>(registerAddress >> 8)
@@ -76,41 +88,78 @@ bool QI2CDevice::read(quint16 registerAddress, quint8 *buffer, quint16 length)
         }
     };
 
-    struct i2c_rdwr_ioctl_data payload =
+    if(!transfer(messages, 2, QI2CStatistics::ReadOperation))
     {
-        .msgs = messages,
-        .nmsgs = 2
-    };
-
-    if(ioctl(m_i2c, I2C_RDWR, &payload) < 0)
-    {
-        delete [] registerBuffer;
         qDebug() << QString("COULD NOT READ 16bit REGISTER 0x%1").arg(registerAddress, 2, 16, '0');
         m_errno = errno;
+        invalidate();
         return false;
     }
 
-    delete [] registerBuffer;
     return true;
 #else
     return false;
 #endif
 }
 
+bool QI2CDevice::read(quint8 registerAddress, std::span<quint8> buffer)
+{
+    return read(registerAddress, buffer.data(), static_cast<quint16>(buffer.size()));
+}
+
+/*!
+ * Reads \a length bytes starting at \a registerAddress from the register
+ * shadow when it knows every one of them, from the device otherwise. Volatile
+ * registers are never shadowed and always go to the bus.
+ */
+bool QI2CDevice::readCached(quint8 registerAddress, quint8 *buffer, quint16 length)
+{
+    if(!m_handle && m_persistent && !start())
+        return false;
+
+    if(m_handle)
+    {
+        QMutexLocker locker(m_handle->mutex());
+        QI2CRegisterShadow *registers = currentShadow();
+        quint16 known = 0;
+
+        while(known < length && registerAddress + known < 256 && registers->isValid(static_cast<quint8>(registerAddress + known)))
+            ++known;
+
+        if(known == length)
+        {
+            for(quint16 i = 0; i < length; ++i)
+                registers->value(static_cast<quint8>(registerAddress + i), &buffer[i]);
+
+            return true;
+        }
+    }
+
+    return read(registerAddress, buffer, length);
+}
+
+/*!
+ * Reads \a bit of \a registerAddress, served from the register shadow when
+ * the register is known.
+ */
 bool QI2CDevice::readBit(quint8 registerAddress, quint8 *buffer, quint8 bit)
 {
     quint8 b;
 
-    if(!read(registerAddress, &b, 1))
+    if(!readCached(registerAddress, &b, 1))
         return false;
 
     *buffer = b & (1 << bit);
     return true;
 }
 
+/*!
+ * Reads \a bitWidth bits of \a registerAddress ending at \a startBit, served
+ * from the register shadow when the register is known.
+ */
 bool QI2CDevice::readBits(quint8 registerAddress, quint8 *buffer, quint8 startBit, quint8 bitWidth)
 {
-    if(!read(registerAddress, buffer, 1))
+    if(!readCached(registerAddress, buffer, 1))
         return false;
 
     quint8 mask = ((1 << bitWidth) - 1) << (startBit - bitWidth + 1);
@@ -120,39 +169,108 @@ bool QI2CDevice::readBits(quint8 registerAddress, quint8 *buffer, quint8 startBi
     return true;
 }
 
+/*!
+ * \brief Reads \a length bytes from a streaming register such as a FIFO port.
+ *
+ * Every chunk re-addresses \a registerAddress, so the register must not
+ * auto-increment. Chunks are as large as maxTransferSize(); if the adapter
+ * refuses a chunk as too long the limit is halved and the chunk retried.
+ */
+bool QI2CDevice::readStream(quint8 registerAddress, quint8 *buffer, quint16 length)
+{
+#ifdef Q_OS_LINUX
+    if(!m_handle && m_persistent && !start())
+        return false;
+
+    quint16 offset = 0;
+
+    while(offset < length)
+    {
+        quint16 chunk = qMin<quint16>(length - offset, m_maxTransferSize);
+
+        struct i2c_msg messages[]
+        {
+            {
+                .addr = m_address,
+                .flags = 0,
+                .len = 1,
+                .buf = &registerAddress
+            },
+            {
+                .addr = m_address,
+                .flags = I2C_M_RD,
+                .len = chunk,
+                .buf = buffer + offset
+            }
+        };
+
+        if(!transfer(messages, 2, QI2CStatistics::StreamOperation))
+        {
+            //adapter quirks (max_read_len) surface as EOPNOTSUPP or EINVAL
+            if((errno == EOPNOTSUPP || errno == EINVAL) && chunk > 32)
+            {
+                m_maxTransferSize = chunk / 2;
+                continue;
+            }
+
+            qDebug() << QString("COULD NOT STREAM REGISTER 0x%1").arg(registerAddress, 2, 16, '0');
+            m_errno = errno;
+            invalidate();
+            return false;
+        }
+
+        offset += chunk;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
 bool QI2CDevice::write(quint8 registerAddress, quint8 *buffer, quint16 length)
+{
+    return write(registerAddress, std::span<const quint8>(buffer, length));
+}
+
+/*!
+ * Writes \a buffer starting at \a registerAddress. The register byte and the
+ * payload have to go out in one message; they are assembled in an inline
+ * buffer that only spills to the heap for payloads over writeInlineSize.
+ */
+bool QI2CDevice::write(quint8 registerAddress, std::span<const quint8> buffer)
 {
 #ifdef Q_OS_LINUX
-    quint16 dataLength = strlen(reinterpret_cast<char*>(buffer));
-    quint8 *data = new quint8[dataLength + 1];
-    data[0] = registerAddress;
-    memcpy(&data[1], buffer, dataLength);
+    if(!m_handle && m_persistent && !start())
+        return false;
+
+    QVarLengthArray<quint8, writeInlineSize + 1> data;
+    data.append(registerAddress);
+    data.append(buffer.data(), static_cast<qsizetype>(buffer.size()));
 
     struct i2c_msg messages[]
     {
         {
             .addr = m_address,
             .flags = 0,
-            .len = length + 1,
-            .buf = data
+            .len = static_cast<quint16>(data.size()),
+            .buf = data.data()
         }
     };
 
-    struct i2c_rdwr_ioctl_data payload =
-    {
-        .msgs = messages,
-        .nmsgs = 1
-    };
+    QMutexLocker locker(m_handle ? m_handle->mutex() : nullptr);
 
-    if(ioctl(m_i2c, I2C_RDWR, &payload) < 0)
+    if(!transfer(messages, 1, QI2CStatistics::WriteOperation))
     {
-        delete [] data;
         qDebug() << QString("COULD NOT WRITE REGISTER 0x%1").arg(registerAddress, 2, 16, '0');
+        m_errno = errno;
+        invalidate();
         return false;
     }
 
-    qDebug() << QString("WROTE 0x%1 TO REGISTER 0x%2").arg(*buffer, 2, 16, '0').arg(registerAddress, 2, 16, '0');
-    delete [] data;
+    if(QI2CRegisterShadow *registers = currentShadow())
+        registers->store(registerAddress, buffer.data(), static_cast<quint16>(buffer.size()));
+
     return true;
 #else
     return false;
@@ -162,7 +280,10 @@ bool QI2CDevice::write(quint8 registerAddress, quint8 *buffer, quint16 length)
 bool QI2CDevice::write(quint16 registerAddress, quint8 *buffer, quint16 length)
 {
 #ifdef Q_OS_LINUX
-    quint8 *registerBuffer = new quint8[2]
+    if(!m_handle && m_persistent && !start())
+        return false;
+
+    quint8 registerBuffer[2]
     {
         static_cast<quint8>(registerAddress),
         static_cast<quint8>(registerAddress >> 8)
@@ -184,20 +305,14 @@ bool QI2CDevice::write(quint16 registerAddress, quint8 *buffer, quint16 length)
         }
     };
 
-    struct i2c_rdwr_ioctl_data payload =
-    {
-        .msgs = messages,
-        .nmsgs = 2
-    };
-
-    if(ioctl(m_i2c, I2C_RDWR, &payload) < 0)
+    if(!transfer(messages, 2, QI2CStatistics::WriteOperation))
     {
-        delete [] registerBuffer;
         qDebug() << QString("COULD NOT WRITE REGISTER 0x%1").arg(registerAddress, 2, 16, '0');
+        m_errno = errno;
+        invalidate();
         return false;
     }
 
-    delete [] registerBuffer;
     return true;
 #else
     return false;
@@ -206,9 +321,17 @@ bool QI2CDevice::write(quint16 registerAddress, quint8 *buffer, quint16 length)
 
 bool QI2CDevice::writeBit(quint8 registerAddress, quint8 bit, bool enabled)
 {
+    if(!m_handle && m_persistent && !start())
+        return false;
+
+    //keep other devices on the bus out of the read-modify-write
+    QMutexLocker locker(m_handle ? m_handle->mutex() : nullptr);
     quint8 b;
 
-    if(!read(registerAddress, &b, 1))
+    //the shadow saves the read half when the register is known
+    QI2CRegisterShadow *registers = currentShadow();
+
+    if(!(registers && registers->value(registerAddress, &b)) && !read(registerAddress, &b, 1))
         return false;
 
     b = enabled ? (b | (1 << bit)) : (b & ~(1 << bit));
@@ -224,8 +347,14 @@ bool QI2CDevice::writeBits(quint8 registerAddress, quint8 buffer, quint8 startBi
     // 10101111 original value (sample)
     // 10100011 original & ~mask
     // 10101011 masked | value
+    if(!m_handle && m_persistent && !start())
+        return false;
+
+    QMutexLocker locker(m_handle ? m_handle->mutex() : nullptr);
     uint8_t b = 0;
-    if(!read(registerAddress, &b, 1))
+    QI2CRegisterShadow *registers = currentShadow();
+
+    if(!(registers && registers->value(registerAddress, &b)) && !read(registerAddress, &b, 1))
         return false;
 
     uint8_t mask = ((1 << bitWidth) - 1) << (startBit - bitWidth + 1);
@@ -239,22 +368,42 @@ bool QI2CDevice::writeBits(quint8 registerAddress, quint8 buffer, quint8 startBi
 bool QI2CDevice::start()
 {
 #ifdef Q_OS_LINUX
-    if(m_i2c < 0)
+    //reuse the shared bus handle and slave binding when nothing has changed
+    if(m_persistent && m_slaveBound && m_handle && m_handle->isOpen())
     {
-        if((m_i2c = open(m_bus.toStdString().c_str(), O_RDWR)) < 0)
+        ++m_openAvoidedCount;
+        errno = 0;
+        return true;
+    }
+
+    if(!m_handle)
+        m_handle = QI2CBus::acquire(m_bus);
+
+    if(!m_handle->isOpen())
+    {
+        if(!m_handle->open())
         {
+            close();
             errno = EBADF;
             return false;
         }
+
+        ++m_openCount;
+    }
+    else
+    {
+        //another device on the bus already holds the transport open
+        ++m_openAvoidedCount;
     }
 
-    if(ioctl(m_i2c, I2C_SLAVE, m_address) < 0)
+    if(!m_handle->bind(m_address))
     {
+        close();
         errno = ENODEV;
-        end();
         return false;
     }
 
+    m_slaveBound = true;
     errno = 0; //errno = 2 after successful start. reset it for error handling
 
     return true;
@@ -265,23 +414,227 @@ bool QI2CDevice::start()
 
 bool QI2CDevice::end()
 {
-#ifdef Q_OS_LINUX
-    if(m_i2c < 0)
+    //persistent connections keep the bus handle until close() is called
+    if(m_persistent)
         return true;
 
-    if(close(m_i2c) < 0)
+    return close();
+}
+
+bool QI2CDevice::close()
+{
+    m_slaveBound = false;
+
+    if(!m_handle)
+        return true;
+
+    ++m_closeCount;
+
+    //the fd is closed once the last device on the bus lets go of it
+    QI2CBus::release(m_handle);
+    m_handle = nullptr;
+
+    return true;
+}
+
+bool QI2CDevice::isOpen() const
+{
+    return m_handle && m_handle->isOpen();
+}
+
+bool QI2CDevice::isPersistent() const
+{
+    return m_persistent;
+}
+
+void QI2CDevice::setPersistent(bool persistent)
+{
+    m_persistent = persistent;
+}
+
+quint64 QI2CDevice::openCount() const
+{
+    return m_openCount;
+}
+
+/*!
+ * Number of start() calls that found the bus transport already open, through
+ * this device's persistent connection or another device on the bus, and so
+ * did not have to open it.
+ */
+quint64 QI2CDevice::openAvoidedCount() const
+{
+    return m_openAvoidedCount;
+}
+
+quint64 QI2CDevice::closeCount() const
+{
+    return m_closeCount;
+}
+
+quint16 QI2CDevice::maxTransferSize() const
+{
+    return m_maxTransferSize;
+}
+
+void QI2CDevice::setMaxTransferSize(quint16 size)
+{
+    m_maxTransferSize = qMax<quint16>(1, size);
+}
+
+QI2CBus *QI2CDevice::handle() const
+{
+    return m_handle;
+}
+
+/*!
+ * Returns the register shadow of this device's bus address. The shadow is
+ * shared with every other QI2CDevice on the same bus and address.
+ */
+QI2CRegisterShadow *QI2CDevice::shadow()
+{
+    if(!m_handle)
+        m_handle = QI2CBus::acquire(m_bus);
+
+    return m_handle->shadow(m_address);
+}
+
+/*!
+ * Re-reads every shadowed register from the device, one burst per run of
+ * consecutive shadowed registers so volatile registers are never touched.
+ * Call it after the device was reset or reconfigured behind our back.
+ */
+bool QI2CDevice::resyncShadow()
+{
+    if(!m_handle && m_persistent && !start())
+        return false;
+
+    QMutexLocker locker(m_handle ? m_handle->mutex() : nullptr);
+    QI2CRegisterShadow *registers = currentShadow();
+
+    //not started in non-persistent mode
+    if(!registers)
     {
-        m_errno = errno;
-        m_i2c = -1;
+        errno = EBADF;
         return false;
     }
 
-    m_i2c = -1;
+    registers->invalidate();
+
+    quint16 first = 0;
+
+    while(first < 256)
+    {
+        if(!registers->isCacheable(static_cast<quint8>(first)))
+        {
+            ++first;
+            continue;
+        }
+
+        quint16 last = first;
+
+        while(last + 1 < 256 && registers->isCacheable(static_cast<quint8>(last + 1)))
+            ++last;
+
+        quint8 buffer[256];
+
+        if(!read(static_cast<quint8>(first), buffer, last - first + 1))
+            return false;
+
+        first = last + 1;
+    }
 
     return true;
-#else
-    return false;
-#endif
+}
+
+void QI2CDevice::invalidateShadow()
+{
+    QMutexLocker locker(m_handle ? m_handle->mutex() : nullptr);
+
+    shadow()->invalidate();
+}
+
+/*!
+ * Forgets the shadowed value of \a registerAddress so its next read goes to
+ * the device.
+ */
+void QI2CDevice::invalidateShadow(quint8 registerAddress)
+{
+    QMutexLocker locker(m_handle ? m_handle->mutex() : nullptr);
+
+    shadow()->invalidate(registerAddress);
+}
+
+/*!
+ * Returns a consistent copy of the traffic counters of this device address,
+ * shared with every other QI2CDevice on the same bus and address. Only reads
+ * the counters, the bus is never opened for it; empty while no handle is
+ * held.
+ */
+QI2CStatistics QI2CDevice::statistics()
+{
+    if(!m_handle)
+        return QI2CStatistics();
+
+    QMutexLocker locker(m_handle->mutex());
+
+    QI2CStatistics statistics = *m_handle->statistics(m_address);
+    statistics.m_snapshotTime = QI2CTransport::timestamp();
+    statistics.m_openCount = m_handle->openCount();
+    statistics.m_closeCount = m_handle->closeCount();
+
+    return statistics;
+}
+
+void QI2CDevice::resetStatistics()
+{
+    //nothing was counted without a handle
+    if(!m_handle)
+        return;
+
+    QMutexLocker locker(m_handle->mutex());
+
+    m_handle->statistics(m_address)->reset();
+}
+
+bool QI2CDevice::transfer(struct i2c_msg *messages, quint32 count, QI2CStatistics::Operation operation)
+{
+    if(!m_handle)
+    {
+        errno = EBADF;
+        return false;
+    }
+
+    //time and count the transfer under the same lock that serializes it
+    QMutexLocker locker(m_handle->mutex());
+
+    quint64 start = QI2CTransport::timestamp();
+    bool result = m_handle->transfer(messages, count);
+    int error = result ? 0 : errno;
+
+    m_handle->statistics(m_address)->record(operation, messages, count, QI2CTransport::timestamp() - start, error);
+
+    errno = error;
+    return result;
+}
+
+/*!
+ * Returns the register shadow of this device without acquiring the bus, or
+ * nullptr while no handle is held. Callers fall back to the device then.
+ */
+QI2CRegisterShadow *QI2CDevice::currentShadow() const
+{
+    return m_handle ? m_handle->shadow(m_address) : nullptr;
+}
+
+void QI2CDevice::invalidate()
+{
+    //rebind this device on its next start(), the bus decides from m_errno
+    //whether the shared fd has to go as well
+    m_slaveBound = false;
+
+    if(m_handle)
+        m_handle->invalidate(m_errno);
 }
 
 quint16 QI2CDevice::address() const
@@ -291,12 +644,18 @@ quint16 QI2CDevice::address() const
 
 void QI2CDevice::setAddress(quint16 address)
 {
+    if(m_address != address)
+        m_slaveBound = false;
+
     m_10BitAddress = true;
     m_address = address;
 }
 
 void QI2CDevice::setAddress(quint8 address)
 {
+    if(m_address != address)
+        m_slaveBound = false;
+
     m_10BitAddress = false;
     m_address = static_cast<quint16>(address);
 }
@@ -308,5 +667,9 @@ QString QI2CDevice::bus() const
 
 void QI2CDevice::setBus(const QString &bus)
 {
+    if(m_bus == bus)
+        return;
+
+    close();
     m_bus = bus;
 }
@@ -3,7 +3,11 @@
 
 #include <QObject>
 #include <QDebug>
+#include <QVarLengthArray>
 #include "qmpu6050_global.h"
+#include "qi2cbus.h"
+
+#include <span>
 
 #ifdef Q_OS_LINUX
 #include "fcntl.h"
@@ -17,23 +21,45 @@ QT_BEGIN_NAMESPACE
 
 class QMPU6_5__EXPORT QI2CDevice
 {
+    Q_DISABLE_COPY(QI2CDevice)
 public:
+    //largest write payload assembled without touching the heap
+    static constexpr qsizetype writeInlineSize = 64;
+
     QI2CDevice() = default;
     QI2CDevice(const QString &bus, const quint8 address);
     QI2CDevice(const QString &bus, const quint16 address);
+    ~QI2CDevice();
 
     bool read(quint8 registerAddress, quint8 *buffer, quint16 length);
     bool read(quint16 registerAddress, quint8 *buffer, quint16 length);
+    bool read(quint8 registerAddress, std::span<quint8> buffer);
+    bool readCached(quint8 registerAddress, quint8 *buffer, quint16 length);
     bool readBit(quint8 registerAddress, quint8 *buffer, quint8 bit);
     bool readBits(quint8 registerAddress, quint8 *buffer, quint8 startBit, quint8 bitWidth = 1);
+    bool readStream(quint8 registerAddress, quint8 *buffer, quint16 length);
 
     bool write(quint8 registerAddress, quint8 *buffer, quint16 length);
     bool write(quint16 registerAddress, quint8 *buffer, quint16 length);
+    bool write(quint8 registerAddress, std::span<const quint8> buffer);
     bool writeBit(quint8 registerAddress, quint8 bit, bool enabled);
     bool writeBits(quint8 registerAddress, quint8 buffer, quint8 startBit, quint8 bitWidth = 1);
 
     bool start();
     bool end();
+    bool close();
+
+    bool isOpen() const;
+
+    bool isPersistent() const;
+    void setPersistent(bool persistent);
+
+    quint64 openCount() const;
+    quint64 openAvoidedCount() const;
+    quint64 closeCount() const;
+
+    quint16 maxTransferSize() const;
+    void setMaxTransferSize(quint16 size);
 
     quint16 address() const;
     void setAddress(quint16 address);
@@ -42,12 +68,41 @@ public:
     QString bus() const;
     void setBus(const QString &bus);
 
+    QI2CBus *handle() const;
+
+    QI2CRegisterShadow *shadow();
+    bool resyncShadow();
+    void invalidateShadow();
+    void invalidateShadow(quint8 registerAddress);
+
+    QI2CStatistics statistics();
+    void resetStatistics();
+
 private:
+    friend class QI2CTransaction;
+
+    bool transfer(struct i2c_msg *messages, quint32 count, QI2CStatistics::Operation operation);
+    void invalidate();
+    QI2CRegisterShadow *currentShadow() const;
+
     bool m_10BitAddress = false;
     quint16 m_address = 0x00;
     QString m_bus;
-    int m_i2c = -1;
+    QI2CBus *m_handle = nullptr;
     int m_errno = 0;
+
+    //persistent connection state. the shared bus handle stays acquired between
+    //start()/end() pairs and is only reopened after an error or a bus/address change
+    bool m_persistent = true;
+    bool m_slaveBound = false;
+
+    quint64 m_openCount = 0;
+    quint64 m_openAvoidedCount = 0;
+    quint64 m_closeCount = 0;
+
+    //largest read the adapter accepts in one message. I2C_RDWR caps a message
+    //at 8192 bytes, adapters with tighter quirks shrink it on first refusal
+    quint16 m_maxTransferSize = 8192;
 };
 
 QT_END_NAMESPACE
@@ -0,0 +1,126 @@
+#include "qi2crecordingtransport.h"
+
+QI2CRecordingTransport::QI2CRecordingTransport(QI2CTransport *transport, const QString &fileName)
+{
+    m_transport = transport;
+    m_file.setFileName(fileName);
+}
+
+QI2CRecordingTransport::~QI2CRecordingTransport()
+{
+    close();
+
+    delete m_transport;
+}
+
+/*!
+ * Opens the wrapped transport and the recording. The file is truncated on
+ * the first open only, so reopens after bus errors keep appending.
+ */
+bool QI2CRecordingTransport::open()
+{
+    if(!m_file.isOpen())
+    {
+        QIODevice::OpenMode mode = QIODevice::WriteOnly | (m_start ? QIODevice::Append : QIODevice::Truncate);
+
+        if(!m_file.open(mode))
+        {
+            qDebug() << "QI2CRecordingTransport: COULD NOT OPEN RECORDING" << m_file.fileName();
+            errno = EIO;
+            return false;
+        }
+
+        m_stream.setDevice(&m_file);
+        m_stream.setByteOrder(QDataStream::LittleEndian);
+
+        if(!m_start)
+        {
+            m_stream << magic << version;
+            m_start = timestamp();
+        }
+    }
+
+    return m_transport->open();
+}
+
+bool QI2CRecordingTransport::close()
+{
+    if(m_file.isOpen())
+    {
+        m_file.flush();
+        m_file.close();
+    }
+
+    return m_transport->close();
+}
+
+bool QI2CRecordingTransport::isOpen() const
+{
+    return m_transport->isOpen();
+}
+
+bool QI2CRecordingTransport::bind(quint16 address)
+{
+    return m_transport->bind(address);
+}
+
+bool QI2CRecordingTransport::transfer(struct i2c_msg *messages, quint32 count)
+{
+    bool result = m_transport->transfer(messages, count);
+    qint32 error = result ? 0 : errno;
+
+    if(m_file.isOpen())
+    {
+        m_stream << (quint64)(timestamp() - m_start) << error << (quint16)count;
+
+        for(quint32 i = 0; i < count; ++i)
+        {
+            const struct i2c_msg &message = messages[i];
+
+            m_stream << (quint16)message.addr << (quint16)message.flags << (quint16)message.len;
+
+            if(!(message.flags & I2C_M_RD) || result)
+                m_stream.writeRawData((const char*)message.buf, message.len);
+        }
+
+        ++m_recordCount;
+    }
+
+    //the record must not clobber the errno of the transfer
+    if(!result)
+        errno = error;
+
+    return result;
+}
+
+QString QI2CRecordingTransport::fileName() const
+{
+    return m_file.fileName();
+}
+
+quint64 QI2CRecordingTransport::recordCount() const
+{
+    return m_recordCount;
+}
+
+/*!
+ * Records every bus acquired afterwards whose path has the form
+ * "<prefix><bus path>@<file>". The bus path may itself use a registered
+ * prefix, e.g. "record:emulator:mpu6050@/tmp/session.qi2c".
+ */
+void QI2CRecordingTransport::registerTransport(const QString &prefix)
+{
+    QI2CTransport::registerFactory(prefix, [prefix](const QString &path) -> QI2CTransport*
+    {
+        QString spec = path.mid(prefix.length());
+        qsizetype separator = spec.lastIndexOf(QLatin1Char('@'));
+
+        if(separator < 0)
+        {
+            qDebug() << "QI2CRecordingTransport: NO RECORDING FILE IN" << path;
+            return nullptr;
+        }
+
+        return new QI2CRecordingTransport(QI2CTransport::create(spec.left(separator)), spec.mid(separator + 1));
+    });
+}
@@ -0,0 +1,67 @@
+#ifndef QI2CRECORDINGTRANSPORT_H
+#define QI2CRECORDINGTRANSPORT_H
+
+#include <QObject>
+#include <QFile>
+#include <QDataStream>
+#include "qmpu6050_global.h"
+#include "qi2ctransport.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Transport decorator logging every transaction to a file
+ *
+ * Forwards all calls to the wrapped transport and appends one record per
+ * transfer() to a compact little-endian binary file:
+ *
+ * \code
+ * header:  quint32 magic 'QI2C', quint16 version
+ * record:  quint64 time (ns since the recording started)
+ *          qint32  result (0 or the errno of the failed transfer)
+ *          quint16 message count
+ *          per message:
+ *            quint16 address, quint16 flags, quint16 length
+ *            payload: written bytes, or read bytes if the transfer succeeded
+ * \endcode
+ *
+ * The first byte of a write message is the register pointer, so the record
+ * carries register, direction and payload of every access. Bus paths of the
+ * form "record:<bus path>@<file>" are recorded once registerTransport() has
+ * been called; QI2CReplayTransport plays the file back.
+ */
+class QMPU6_5__EXPORT QI2CRecordingTransport : public QI2CTransport
+{
+    Q_DISABLE_COPY(QI2CRecordingTransport)
+public:
+    static constexpr quint32 magic = 0x43324951;
+    static constexpr quint16 version = 1;
+
+    QI2CRecordingTransport(QI2CTransport *transport, const QString &fileName);
+    ~QI2CRecordingTransport();
+
+    virtual bool open() override;
+    virtual bool close() override;
+    virtual bool isOpen() const override;
+
+    virtual bool bind(quint16 address) override;
+    virtual bool transfer(struct i2c_msg *messages, quint32 count) override;
+
+    QString fileName() const;
+    quint64 recordCount() const;
+
+    static void registerTransport(const QString &prefix = QStringLiteral("record:"));
+
+private:
+    QI2CTransport *m_transport = nullptr;
+
+    QFile m_file;
+    QDataStream m_stream;
+
+    //0 until the file has been created, later opens append to it
+    quint64 m_start = 0;
+    quint64 m_recordCount = 0;
+};
+
+QT_END_NAMESPACE
+#endif // QI2CRECORDINGTRANSPORT_H
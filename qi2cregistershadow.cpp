@@ -0,0 +1,141 @@
+#include "qi2cregistershadow.h"
+
+#include <string.h>
+
+QI2CRegisterShadow::QI2CRegisterShadow()
+{
+    memset(m_values, 0, sizeof(m_values));
+    memset(m_selfClearing, 0, sizeof(m_selfClearing));
+}
+
+/*!
+ * Marks registers \a first to \a last as shadowed.
+ */
+void QI2CRegisterShadow::setCacheable(quint8 first, quint8 last)
+{
+    for(quint16 i = first; i <= last; ++i)
+        m_cacheable.set(i);
+}
+
+/*!
+ * Excludes registers \a first to \a last from the shadow, they are always
+ * read from the device.
+ */
+void QI2CRegisterShadow::setVolatile(quint8 first, quint8 last)
+{
+    for(quint16 i = first; i <= last; ++i)
+    {
+        m_cacheable.reset(i);
+        m_valid.reset(i);
+    }
+}
+
+void QI2CRegisterShadow::setVolatile(quint8 registerAddress)
+{
+    setVolatile(registerAddress, registerAddress);
+}
+
+/*!
+ * Declares the bits in \a mask of \a registerAddress as cleared by the device
+ * after they are written.
+ */
+void QI2CRegisterShadow::setSelfClearing(quint8 registerAddress, quint8 mask)
+{
+    m_selfClearing[registerAddress] = mask;
+}
+
+quint8 QI2CRegisterShadow::selfClearingMask(quint8 registerAddress) const
+{
+    return m_selfClearing[registerAddress];
+}
+
+bool QI2CRegisterShadow::isCacheable(quint8 registerAddress) const
+{
+    return m_cacheable.test(registerAddress);
+}
+
+bool QI2CRegisterShadow::isValid(quint8 registerAddress) const
+{
+    return m_valid.test(registerAddress);
+}
+
+bool QI2CRegisterShadow::isConfigured() const
+{
+    return m_cacheable.any();
+}
+
+/*!
+ * Returns the shadowed value of \a registerAddress in \a value. Returns false
+ * if the register is not shadowed or not known yet.
+ */
+bool QI2CRegisterShadow::value(quint8 registerAddress, quint8 *value)
+{
+    if(!m_valid.test(registerAddress))
+    {
+        if(m_cacheable.test(registerAddress))
+            ++m_missCount;
+
+        return false;
+    }
+
+    ++m_hitCount;
+    *value = m_values[registerAddress];
+
+    return true;
+}
+
+/*!
+ * Like value(), but leaves the hit and miss counters alone. Meant for
+ * restoring the configuration after the device lost it.
+ */
+bool QI2CRegisterShadow::peek(quint8 registerAddress, quint8 *value) const
+{
+    if(!m_valid.test(registerAddress))
+        return false;
+
+    *value = m_values[registerAddress];
+    return true;
+}
+
+void QI2CRegisterShadow::store(quint8 registerAddress, quint8 value)
+{
+    if(!m_cacheable.test(registerAddress))
+        return;
+
+    m_values[registerAddress] = value & ~m_selfClearing[registerAddress];
+    m_valid.set(registerAddress);
+}
+
+/*!
+ * Stores a burst of \a length values starting at \a registerAddress. Bursts
+ * that start on a register outside the shadow are ignored: those are FIFO or
+ * memory ports that do not auto-increment.
+ */
+void QI2CRegisterShadow::store(quint8 registerAddress, const quint8 *values, quint16 length)
+{
+    if(!m_cacheable.test(registerAddress))
+        return;
+
+    for(quint16 i = 0; i < length && registerAddress + i < 256; ++i)
+        store(static_cast<quint8>(registerAddress + i), values[i]);
+}
+
+void QI2CRegisterShadow::invalidate()
+{
+    m_valid.reset();
+}
+
+void QI2CRegisterShadow::invalidate(quint8 registerAddress)
+{
+    m_valid.reset(registerAddress);
+}
+
+quint64 QI2CRegisterShadow::hitCount() const
+{
+    return m_hitCount;
+}
+
+quint64 QI2CRegisterShadow::missCount() const
+{
+    return m_missCount;
+}
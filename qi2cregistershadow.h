@@ -0,0 +1,62 @@
+#ifndef QI2CREGISTERSHADOW_H
+#define QI2CREGISTERSHADOW_H
+
+#include <QtCore/qglobal.h>
+#include "qmpu6050_global.h"
+
+#include <bitset>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Last known contents of the 8-bit registers of one I2C device
+ *
+ * Only registers marked cacheable and not volatile are shadowed. Writes and
+ * reads through QI2CDevice keep the shadow current, which lets writeBit()
+ * and writeBits() skip the read half of their read-modify-write.
+ *
+ * Bits that the device clears by itself after they are written (reset and
+ * trigger bits) are declared with setSelfClearing() and are never stored as
+ * set. Status and data registers that change on their own must be declared
+ * volatile. The shadow of a bus address is shared by every QI2CDevice on
+ * that address and is guarded by the bus mutex.
+ */
+class QMPU6_5__EXPORT QI2CRegisterShadow
+{
+public:
+    QI2CRegisterShadow();
+
+    void setCacheable(quint8 first, quint8 last);
+    void setVolatile(quint8 first, quint8 last);
+    void setVolatile(quint8 registerAddress);
+    void setSelfClearing(quint8 registerAddress, quint8 mask);
+
+    bool isCacheable(quint8 registerAddress) const;
+    bool isValid(quint8 registerAddress) const;
+    bool isConfigured() const;
+    quint8 selfClearingMask(quint8 registerAddress) const;
+
+    bool value(quint8 registerAddress, quint8 *value);
+    bool peek(quint8 registerAddress, quint8 *value) const;
+    void store(quint8 registerAddress, quint8 value);
+    void store(quint8 registerAddress, const quint8 *values, quint16 length);
+
+    void invalidate();
+    void invalidate(quint8 registerAddress);
+
+    quint64 hitCount() const;
+    quint64 missCount() const;
+
+private:
+    quint8 m_values[256];
+    quint8 m_selfClearing[256];
+
+    std::bitset<256> m_cacheable;
+    std::bitset<256> m_valid;
+
+    quint64 m_hitCount = 0;
+    quint64 m_missCount = 0;
+};
+
+QT_END_NAMESPACE
+#endif // QI2CREGISTERSHADOW_H
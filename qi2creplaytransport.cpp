@@ -0,0 +1,258 @@
+#include "qi2creplaytransport.h"
+#include "qi2crecordingtransport.h"
+
+#include <QtEndian>
+#include <cstring>
+#include <ctime>
+
+//size of the fixed part of a record and of a message header
+static constexpr qsizetype recordHeaderSize = 8 + 4 + 2;
+static constexpr qsizetype messageHeaderSize = 2 + 2 + 2;
+
+QI2CReplayTransport::QI2CReplayTransport(const QString &fileName)
+{
+    m_fileName = fileName;
+}
+
+bool QI2CReplayTransport::open()
+{
+    if(!m_loaded && !load())
+    {
+        errno = EIO;
+        return false;
+    }
+
+    if(!m_start)
+        m_start = timestamp();
+
+    m_open = true;
+    return true;
+}
+
+bool QI2CReplayTransport::close()
+{
+    m_open = false;
+    return true;
+}
+
+bool QI2CReplayTransport::isOpen() const
+{
+    return m_open;
+}
+
+bool QI2CReplayTransport::bind(quint16 address)
+{
+    Q_UNUSED(address)
+    return true;
+}
+
+/*!
+ * Serves the next record to \a messages.
+ */
+bool QI2CReplayTransport::transfer(struct i2c_msg *messages, quint32 count)
+{
+    if(!m_open)
+    {
+        errno = EBADF;
+        return false;
+    }
+
+    if(atEnd())
+    {
+        if(!m_looping || m_position == m_first)
+        {
+            errno = ENODATA;
+            return false;
+        }
+
+        rewind();
+    }
+
+    const char *data = m_data.constData();
+    qsizetype position = m_position;
+
+    quint64 time = qFromLittleEndian<quint64>(data + position);
+    qint32 error = qFromLittleEndian<qint32>(data + position + 8);
+    quint16 recorded = qFromLittleEndian<quint16>(data + position + 12);
+    position += recordHeaderSize;
+
+    if(recorded != count)
+    {
+        errno = EPROTO;
+        return false;
+    }
+
+    //validate the whole record before touching any buffer
+    qsizetype payload = position;
+
+    for(quint32 i = 0; i < count; ++i)
+    {
+        if(payload + messageHeaderSize > m_data.size())
+        {
+            errno = EPROTO;
+            return false;
+        }
+
+        quint16 address = qFromLittleEndian<quint16>(data + payload);
+        quint16 flags = qFromLittleEndian<quint16>(data + payload + 2);
+        quint16 length = qFromLittleEndian<quint16>(data + payload + 4);
+        payload += messageHeaderSize;
+
+        if(address != messages[i].addr || (flags & I2C_M_RD) != (messages[i].flags & I2C_M_RD) || length != messages[i].len)
+        {
+            errno = EPROTO;
+            return false;
+        }
+
+        if(!(flags & I2C_M_RD) || !error)
+            payload += length;
+    }
+
+    if(payload > m_data.size())
+    {
+        errno = EPROTO;
+        return false;
+    }
+
+    if(m_paced)
+    {
+        quint64 deadline = m_start + time;
+
+        struct timespec wakeup;
+        wakeup.tv_sec = deadline / 1000000000ull;
+        wakeup.tv_nsec = deadline % 1000000000ull;
+
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, nullptr) == EINTR);
+    }
+
+    bool mismatch = false;
+
+    for(quint32 i = 0; i < count; ++i)
+    {
+        struct i2c_msg &message = messages[i];
+        position += messageHeaderSize;
+
+        if(message.flags & I2C_M_RD)
+        {
+            if(error)
+                continue;
+
+            memcpy(message.buf, data + position, message.len);
+        }
+        else if(memcmp(message.buf, data + position, message.len) != 0)
+            mismatch = true;
+
+        position += message.len;
+    }
+
+    m_position = position;
+    ++m_recordCount;
+
+    if(mismatch)
+        ++m_mismatchCount;
+
+    if(error)
+    {
+        errno = error;
+        return false;
+    }
+
+    return true;
+}
+
+QString QI2CReplayTransport::fileName() const
+{
+    return m_fileName;
+}
+
+bool QI2CReplayTransport::isLooping() const
+{
+    return m_looping;
+}
+
+/*!
+ * Restarts from the first record once the recording is exhausted instead of
+ * failing with ENODATA.
+ */
+void QI2CReplayTransport::setLooping(bool looping)
+{
+    m_looping = looping;
+}
+
+bool QI2CReplayTransport::isPaced() const
+{
+    return m_paced;
+}
+
+/*!
+ * Delays every transfer until its recorded time relative to the start of the
+ * replay, reproducing the timing of the original session.
+ */
+void QI2CReplayTransport::setPaced(bool paced)
+{
+    m_paced = paced;
+}
+
+void QI2CReplayTransport::rewind()
+{
+    m_position = m_first;
+    m_start = timestamp();
+}
+
+bool QI2CReplayTransport::atEnd() const
+{
+    return m_position + recordHeaderSize > m_data.size();
+}
+
+quint64 QI2CReplayTransport::recordCount() const
+{
+    return m_recordCount;
+}
+
+quint64 QI2CReplayTransport::mismatchCount() const
+{
+    return m_mismatchCount;
+}
+
+/*!
+ * Replays every bus acquired afterwards whose path has the form
+ * "<prefix><file>".
+ */
+void QI2CReplayTransport::registerTransport(const QString &prefix)
+{
+    QI2CTransport::registerFactory(prefix, [prefix](const QString &path) -> QI2CTransport*
+    {
+        return new QI2CReplayTransport(path.mid(prefix.length()));
+    });
+}
+
+bool QI2CReplayTransport::load()
+{
+    QFile file(m_fileName);
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "QI2CReplayTransport: COULD NOT OPEN RECORDING" << m_fileName;
+        return false;
+    }
+
+    m_data = file.readAll();
+
+    if(m_data.size() < 6 || qFromLittleEndian<quint32>(m_data.constData()) != QI2CRecordingTransport::magic)
+    {
+        qDebug() << "QI2CReplayTransport: NOT A RECORDING" << m_fileName;
+        return false;
+    }
+
+    if(qFromLittleEndian<quint16>(m_data.constData() + 4) != QI2CRecordingTransport::version)
+    {
+        qDebug() << "QI2CReplayTransport: UNSUPPORTED RECORDING VERSION" << m_fileName;
+        return false;
+    }
+
+    m_first = 6;
+    m_position = m_first;
+    m_loaded = true;
+
+    return true;
+}
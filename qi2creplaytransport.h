@@ -0,0 +1,81 @@
+#ifndef QI2CREPLAYTRANSPORT_H
+#define QI2CREPLAYTRANSPORT_H
+
+#include <QObject>
+#include <QFile>
+#include <QByteArray>
+#include "qmpu6050_global.h"
+#include "qi2ctransport.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Transport serving a QI2CRecordingTransport file back
+ *
+ * Each transfer() consumes the next record: read messages are filled with
+ * the recorded bytes and the recorded result is returned, including failed
+ * transfers with their errno. The recording is loaded into memory on open()
+ * so replay runs at full speed unless setPaced() is enabled.
+ *
+ * A transfer whose shape (message count, addresses, directions or lengths)
+ * differs from the record fails with EPROTO without consuming it. Written
+ * payloads that differ from the recording are only counted in
+ * mismatchCount(). Past the last record transfers fail with ENODATA unless
+ * looping is enabled.
+ *
+ * Bus paths of the form "replay:<file>" are replayed once
+ * registerTransport() has been called.
+ */
+class QMPU6_5__EXPORT QI2CReplayTransport : public QI2CTransport
+{
+    Q_DISABLE_COPY(QI2CReplayTransport)
+public:
+    explicit QI2CReplayTransport(const QString &fileName);
+
+    virtual bool open() override;
+    virtual bool close() override;
+    virtual bool isOpen() const override;
+
+    virtual bool bind(quint16 address) override;
+    virtual bool transfer(struct i2c_msg *messages, quint32 count) override;
+
+    QString fileName() const;
+
+    bool isLooping() const;
+    void setLooping(bool looping);
+
+    bool isPaced() const;
+    void setPaced(bool paced);
+
+    void rewind();
+    bool atEnd() const;
+
+    quint64 recordCount() const;
+    quint64 mismatchCount() const;
+
+    static void registerTransport(const QString &prefix = QStringLiteral("replay:"));
+
+private:
+    bool load();
+
+    QString m_fileName;
+    QByteArray m_data;
+    bool m_open = false;
+    bool m_loaded = false;
+
+    bool m_looping = false;
+    bool m_paced = false;
+
+    //offset of the next record, and of the first one
+    qsizetype m_position = 0;
+    qsizetype m_first = 0;
+
+    //monotonic time replay started at, for pacing
+    quint64 m_start = 0;
+
+    quint64 m_recordCount = 0;
+    quint64 m_mismatchCount = 0;
+};
+
+QT_END_NAMESPACE
+#endif // QI2CREPLAYTRANSPORT_H
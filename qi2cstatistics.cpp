@@ -0,0 +1,246 @@
+#include "qi2cstatistics.h"
+
+#include <bit>
+
+void QI2CLatencyHistogram::record(quint64 value)
+{
+    ++m_buckets[bucketIndex(value)];
+
+    if(!m_count || value < m_minimum)
+        m_minimum = value;
+    if(value > m_maximum)
+        m_maximum = value;
+
+    ++m_count;
+    m_total += value;
+}
+
+void QI2CLatencyHistogram::add(const QI2CLatencyHistogram &other)
+{
+    if(!other.m_count)
+        return;
+
+    for(int i = 0; i < bucketCount; ++i)
+        m_buckets[i] += other.m_buckets[i];
+
+    if(!m_count || other.m_minimum < m_minimum)
+        m_minimum = other.m_minimum;
+    if(other.m_maximum > m_maximum)
+        m_maximum = other.m_maximum;
+
+    m_count += other.m_count;
+    m_total += other.m_total;
+}
+
+void QI2CLatencyHistogram::reset()
+{
+    *this = QI2CLatencyHistogram();
+}
+
+quint64 QI2CLatencyHistogram::count() const
+{
+    return m_count;
+}
+
+quint64 QI2CLatencyHistogram::minimum() const
+{
+    return m_minimum;
+}
+
+quint64 QI2CLatencyHistogram::maximum() const
+{
+    return m_maximum;
+}
+
+qreal QI2CLatencyHistogram::mean() const
+{
+    return m_count ? (qreal)m_total / m_count : 0;
+}
+
+quint64 QI2CLatencyHistogram::total() const
+{
+    return m_total;
+}
+
+/*!
+ * Returns the value \a percentile (0-100) of the recorded values are at or
+ * below, reported as the upper bound of its bucket and capped at maximum().
+ */
+quint64 QI2CLatencyHistogram::valueAtPercentile(qreal percentile) const
+{
+    if(!m_count)
+        return 0;
+
+    quint64 rank = (quint64)qBound<qreal>(1, percentile / 100 * m_count + 0.5, m_count);
+    quint64 seen = 0;
+
+    for(int i = 0; i < bucketCount; ++i)
+    {
+        seen += m_buckets[i];
+
+        if(seen >= rank)
+            return qMin(bucketValue(i), m_maximum);
+    }
+
+    return m_maximum;
+}
+
+quint64 QI2CLatencyHistogram::bucket(int index) const
+{
+    return m_buckets[index];
+}
+
+int QI2CLatencyHistogram::bucketIndex(quint64 value)
+{
+    if(value < subBucketCount)
+        return (int)value;
+
+    int shift = std::bit_width(value) - subBucketBits - 1;
+
+    if(shift >= magnitudeCount)
+        return bucketCount - 1;
+
+    return (shift + 1) * subBucketCount + (int)(value >> shift) - subBucketCount;
+}
+
+/*!
+ * Returns the largest value that lands in bucket \a index.
+ */
+quint64 QI2CLatencyHistogram::bucketValue(int index)
+{
+    if(index < subBucketCount)
+        return index;
+
+    int shift = index / subBucketCount - 1;
+    quint64 subBucket = index % subBucketCount + subBucketCount;
+
+    return ((subBucket + 1) << shift) - 1;
+}
+
+QI2CStatistics::QI2CStatistics()
+{
+    m_since = QI2CTransport::timestamp();
+}
+
+/*!
+ * Counts one transfer of \a count \a messages under \a operation that took
+ * \a latency ns and failed with \a error, or succeeded if it is 0.
+ */
+void QI2CStatistics::record(Operation operation, const struct i2c_msg *messages, quint32 count, quint64 latency, int error)
+{
+    ++m_transactions[operation];
+    m_latency[operation].record(latency);
+    m_busyTime += latency;
+
+    if(error)
+    {
+        ++m_failures[operation];
+        ++m_errors[error > 0 && error < errorCodeCount ? error : errorOther];
+        return;
+    }
+
+    for(quint32 i = 0; i < count; ++i)
+    {
+        if(messages[i].flags & I2C_M_RD)
+            m_bytesRead += messages[i].len;
+        else
+            m_bytesWritten += messages[i].len;
+    }
+}
+
+void QI2CStatistics::reset()
+{
+    *this = QI2CStatistics();
+}
+
+quint64 QI2CStatistics::transactionCount(Operation operation) const
+{
+    return m_transactions[operation];
+}
+
+quint64 QI2CStatistics::transactionCount() const
+{
+    quint64 count = 0;
+
+    for(int i = 0; i < OperationCount; ++i)
+        count += m_transactions[i];
+
+    return count;
+}
+
+quint64 QI2CStatistics::failureCount(Operation operation) const
+{
+    return m_failures[operation];
+}
+
+quint64 QI2CStatistics::failureCount() const
+{
+    quint64 count = 0;
+
+    for(int i = 0; i < OperationCount; ++i)
+        count += m_failures[i];
+
+    return count;
+}
+
+/*!
+ * Returns how many transfers failed with errno \a error.
+ */
+quint64 QI2CStatistics::errorCount(int error) const
+{
+    if(error <= 0 || error >= errorCodeCount)
+        return m_errors[errorOther];
+
+    return m_errors[error];
+}
+
+quint64 QI2CStatistics::bytesRead() const
+{
+    return m_bytesRead;
+}
+
+quint64 QI2CStatistics::bytesWritten() const
+{
+    return m_bytesWritten;
+}
+
+const QI2CLatencyHistogram &QI2CStatistics::latency(Operation operation) const
+{
+    return m_latency[operation];
+}
+
+/*!
+ * Returns the ns spent inside transfers since the counters were reset.
+ */
+quint64 QI2CStatistics::busyTime() const
+{
+    return m_busyTime;
+}
+
+/*!
+ * Returns the ns between the last reset and the moment this snapshot was
+ * taken, or now for the live counters.
+ */
+quint64 QI2CStatistics::elapsedTime() const
+{
+    return (m_snapshotTime ? m_snapshotTime : QI2CTransport::timestamp()) - m_since;
+}
+
+/*!
+ * Returns the share of elapsedTime() the device kept the bus busy.
+ */
+qreal QI2CStatistics::utilization() const
+{
+    quint64 elapsed = elapsedTime();
+    return elapsed ? (qreal)m_busyTime / elapsed : 0;
+}
+
+quint64 QI2CStatistics::openCount() const
+{
+    return m_openCount;
+}
+
+quint64 QI2CStatistics::closeCount() const
+{
+    return m_closeCount;
+}
@@ -0,0 +1,127 @@
+#ifndef QI2CSTATISTICS_H
+#define QI2CSTATISTICS_H
+
+#include <QtCore/qglobal.h>
+#include <QMetaType>
+#include "qmpu6050_global.h"
+#include "qi2ctransport.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Log-linear latency histogram in the style of HdrHistogram
+ *
+ * Values are nanoseconds. Below 16 ns every value has its own bucket; above
+ * that each power of two is split into 16 linear sub-buckets, so a bucket is
+ * never wider than 1/16 of its value. Recording is a shift and an increment,
+ * values beyond about 4.3 s land in the last bucket.
+ */
+class QMPU6_5__EXPORT QI2CLatencyHistogram
+{
+public:
+    static constexpr int subBucketBits = 4;
+    static constexpr int subBucketCount = 1 << subBucketBits;
+    static constexpr int magnitudeCount = 32 - subBucketBits;
+    static constexpr int bucketCount = (magnitudeCount + 1) * subBucketCount;
+
+    void record(quint64 value);
+    void add(const QI2CLatencyHistogram &other);
+    void reset();
+
+    quint64 count() const;
+    quint64 minimum() const;
+    quint64 maximum() const;
+    qreal mean() const;
+    quint64 total() const;
+
+    quint64 valueAtPercentile(qreal percentile) const;
+
+    quint64 bucket(int index) const;
+    static int bucketIndex(quint64 value);
+    static quint64 bucketValue(int index);
+
+private:
+    quint64 m_buckets[bucketCount] = {};
+
+    quint64 m_count = 0;
+    quint64 m_total = 0;
+    quint64 m_minimum = 0;
+    quint64 m_maximum = 0;
+};
+
+/*!
+ * \brief Traffic counters and latency histograms of one I2C device
+ *
+ * Every transfer a QI2CDevice issues is recorded under its operation type
+ * together with the bytes moved, its latency and, for failures, its errno.
+ * The live counters are kept per bus address next to the register shadow
+ * and updated with the bus mutex held; QI2CDevice::statistics() hands out
+ * consistent copies.
+ */
+class QMPU6_5__EXPORT QI2CStatistics
+{
+public:
+    enum Operation
+    {
+        ReadOperation = 0,
+        WriteOperation,
+        StreamOperation,
+        TransactionOperation,
+        OperationCount
+    };
+
+    //errno values above this are counted as ErrorOther
+    static constexpr int errorCodeCount = 134;
+    static constexpr int errorOther = 0;
+
+    QI2CStatistics();
+
+    void record(Operation operation, const struct i2c_msg *messages, quint32 count, quint64 latency, int error);
+    void reset();
+
+    quint64 transactionCount(Operation operation) const;
+    quint64 transactionCount() const;
+    quint64 failureCount(Operation operation) const;
+    quint64 failureCount() const;
+    quint64 errorCount(int error) const;
+
+    quint64 bytesRead() const;
+    quint64 bytesWritten() const;
+
+    const QI2CLatencyHistogram &latency(Operation operation) const;
+
+    quint64 busyTime() const;
+    quint64 elapsedTime() const;
+    qreal utilization() const;
+
+    quint64 openCount() const;
+    quint64 closeCount() const;
+
+private:
+    quint64 m_transactions[OperationCount] = {};
+    quint64 m_failures[OperationCount] = {};
+    QI2CLatencyHistogram m_latency[OperationCount];
+
+    quint64 m_errors[errorCodeCount] = {};
+
+    quint64 m_bytesRead = 0;
+    quint64 m_bytesWritten = 0;
+
+    //ns spent inside transfers, the time the counters started at and the
+    //time a copy was handed out
+    quint64 m_busyTime = 0;
+    quint64 m_since = 0;
+    quint64 m_snapshotTime = 0;
+
+    //bus reopens, filled in by QI2CDevice::statistics()
+    quint64 m_openCount = 0;
+    quint64 m_closeCount = 0;
+
+    friend class QI2CDevice;
+};
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(QI2CStatistics)
+
+#endif // QI2CSTATISTICS_H
@@ -0,0 +1,202 @@
+#include "qi2ctransaction.h"
+
+QI2CTransaction::QI2CTransaction(QI2CDevice *device)
+{
+    m_device = device;
+}
+
+/*!
+ * Queues a read of \a length bytes starting at \a registerAddress into
+ * \a buffer. \a buffer is filled by submit().
+ */
+bool QI2CTransaction::read(quint8 registerAddress, quint8 *buffer, quint16 length)
+{
+    if(m_messageCount + 2 > maxMessages)
+        return false;
+
+    Operation operation;
+    operation.read = true;
+    operation.registerAddress = registerAddress;
+    operation.buffer = buffer;
+    operation.length = length;
+    operation.offset = m_data.size();
+
+    m_data.append(registerAddress);
+    m_operations.append(operation);
+    m_messageCount += 2;
+
+    //a read of a register written earlier in the batch returns the new value
+    m_pending.reset(registerAddress);
+
+    return true;
+}
+
+/*!
+ * Queues a write of \a length bytes from \a buffer starting at
+ * \a registerAddress. The payload is copied, \a buffer may be reused at once.
+ */
+bool QI2CTransaction::write(quint8 registerAddress, const quint8 *buffer, quint16 length)
+{
+    if(m_messageCount + 1 > maxMessages)
+        return false;
+
+    Operation operation;
+    operation.read = false;
+    operation.registerAddress = registerAddress;
+    operation.length = length;
+    operation.offset = m_data.size();
+
+    m_data.append(registerAddress);
+    m_data.append(buffer, length);
+    m_operations.append(operation);
+    m_messageCount += 1;
+
+    if(length == 1)
+    {
+        m_pendingValues[registerAddress] = buffer[0];
+        m_pending.set(registerAddress);
+    }
+    else
+        m_pending.reset(registerAddress);
+
+    return true;
+}
+
+bool QI2CTransaction::write(quint8 registerAddress, quint8 value)
+{
+    return write(registerAddress, &value, 1);
+}
+
+bool QI2CTransaction::writeBit(quint8 registerAddress, quint8 bit, bool enabled)
+{
+    quint8 b;
+
+    if(!current(registerAddress, &b))
+        return false;
+
+    b = enabled ? (b | (1 << bit)) : (b & ~(1 << bit));
+    return write(registerAddress, b);
+}
+
+bool QI2CTransaction::writeBits(quint8 registerAddress, quint8 buffer, quint8 startBit, quint8 bitWidth)
+{
+    quint8 b;
+
+    if(!current(registerAddress, &b))
+        return false;
+
+    quint8 mask = ((1 << bitWidth) - 1) << (startBit - bitWidth + 1);
+    buffer <<= (startBit - bitWidth + 1);
+    buffer &= mask;
+    b &= ~(mask);
+    b |= buffer;
+    return write(registerAddress, b);
+}
+
+/*!
+ * Sends every queued operation in a single I2C_RDWR ioctl and clears the
+ * batch. On failure no read buffer is valid and the shadow is left as is.
+ */
+bool QI2CTransaction::submit()
+{
+#ifdef Q_OS_LINUX
+    if(m_operations.isEmpty())
+        return true;
+
+    if(!m_device->start())
+    {
+        clear();
+        return false;
+    }
+
+    QVarLengthArray<struct i2c_msg, maxMessages> messages;
+
+    for(const Operation &operation : m_operations)
+    {
+        struct i2c_msg message;
+        message.addr = m_device->m_address;
+        message.flags = 0;
+        message.len = operation.read ? 1 : operation.length + 1;
+        message.buf = m_data.data() + operation.offset;
+
+        messages.append(message);
+
+        if(!operation.read)
+            continue;
+
+        message.flags = I2C_M_RD;
+        message.len = operation.length;
+        message.buf = operation.buffer;
+
+        messages.append(message);
+    }
+
+    QMutexLocker locker(m_device->m_handle ? m_device->m_handle->mutex() : nullptr);
+
+    if(!m_device->transfer(messages.data(), static_cast<quint32>(messages.size()), QI2CStatistics::TransactionOperation))
+    {
+        qDebug() << QString("COULD NOT SUBMIT TRANSACTION OF %1 MESSAGES").arg(messages.size());
+        m_device->m_errno = errno;
+        m_device->invalidate();
+        clear();
+        return false;
+    }
+
+    QI2CRegisterShadow *shadow = m_device->m_handle->shadow(m_device->m_address);
+
+    for(const Operation &operation : m_operations)
+    {
+        if(operation.read)
+            shadow->store(operation.registerAddress, operation.buffer, operation.length);
+        else
+            shadow->store(operation.registerAddress, m_data.data() + operation.offset + 1, operation.length);
+    }
+
+    clear();
+    return true;
+#else
+    clear();
+    return false;
+#endif
+}
+
+void QI2CTransaction::clear()
+{
+    m_operations.clear();
+    m_data.clear();
+    m_pending.reset();
+    m_messageCount = 0;
+}
+
+quint32 QI2CTransaction::messageCount() const
+{
+    return m_messageCount;
+}
+
+bool QI2CTransaction::isEmpty() const
+{
+    return m_operations.isEmpty();
+}
+
+//value a bit write builds on: queued write, then shadow, then the device.
+//self-clearing bits are dropped so setting another bit of the register
+//does not trigger a queued reset a second time
+bool QI2CTransaction::current(quint8 registerAddress, quint8 *value)
+{
+    quint8 selfClearing = 0;
+
+    {
+        QMutexLocker locker(m_device->handle() ? m_device->handle()->mutex() : nullptr);
+        QI2CRegisterShadow *shadow = m_device->shadow();
+
+        selfClearing = shadow->selfClearingMask(registerAddress);
+
+        if(m_pending.test(registerAddress))
+            *value = m_pendingValues[registerAddress];
+        else if(!shadow->value(registerAddress, value) && !m_device->read(registerAddress, value, 1))
+            return false;
+    }
+
+    *value &= ~selfClearing;
+    return true;
+}
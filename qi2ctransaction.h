@@ -0,0 +1,74 @@
+#ifndef QI2CTRANSACTION_H
+#define QI2CTRANSACTION_H
+
+#include <QObject>
+#include <QVarLengthArray>
+#include "qmpu6050_global.h"
+#include "qi2cdevice.h"
+
+#include <bitset>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Batch of register reads and writes submitted in one I2C_RDWR ioctl
+ *
+ * Operations are queued in order and go out back to back with repeated
+ * starts when submit() is called. Read results land in the buffers passed to
+ * read(); the register shadow is updated for every operation once the
+ * transfer succeeded.
+ *
+ * A read takes two messages and a write one; the kernel accepts at most
+ * maxMessages per ioctl, so queueing fails once the batch is full.
+ *
+ * writeBit() and writeBits() resolve the rest of the register from earlier
+ * writes in the same batch, then from the shadow, and only read the device
+ * when neither knows the value.
+ *
+ * All bookkeeping lives in inline storage, building and submitting a batch
+ * does not allocate unless the write payloads exceed 256 bytes.
+ */
+class QMPU6_5__EXPORT QI2CTransaction
+{
+    Q_DISABLE_COPY(QI2CTransaction)
+public:
+    static constexpr quint32 maxMessages = 42; //I2C_RDWR_IOCTL_MAX_MSGS
+
+    explicit QI2CTransaction(QI2CDevice *device);
+
+    bool read(quint8 registerAddress, quint8 *buffer, quint16 length);
+    bool write(quint8 registerAddress, const quint8 *buffer, quint16 length);
+    bool write(quint8 registerAddress, quint8 value);
+    bool writeBit(quint8 registerAddress, quint8 bit, bool enabled);
+    bool writeBits(quint8 registerAddress, quint8 buffer, quint8 startBit, quint8 bitWidth = 1);
+
+    bool submit();
+    void clear();
+
+    quint32 messageCount() const;
+    bool isEmpty() const;
+
+private:
+    struct Operation
+    {
+        bool read = false;
+        quint8 registerAddress = 0;
+        quint8 *buffer = nullptr; //read destination
+        quint16 length = 0;
+        qsizetype offset = 0; //register byte, followed by the write payload, in m_data
+    };
+
+    bool current(quint8 registerAddress, quint8 *value);
+
+    QI2CDevice *m_device = nullptr;
+    QVarLengthArray<Operation, maxMessages> m_operations;
+    QVarLengthArray<quint8, 256> m_data;
+
+    //values queued for single register writes in this batch
+    quint8 m_pendingValues[256];
+    std::bitset<256> m_pending;
+    quint32 m_messageCount = 0;
+};
+
+QT_END_NAMESPACE
+#endif // QI2CTRANSACTION_H
@@ -0,0 +1,143 @@
+#include "qi2ctransport.h"
+
+#include <unistd.h>
+#include <ctime>
+
+//transport factories keyed by bus path prefix
+static QMutex factoryMutex;
+static QMap<QString, QI2CTransport::Factory> factories;
+
+/*!
+ * Routes every bus whose path starts with \a prefix to transports created by
+ * \a factory. Only buses acquired afterwards are affected.
+ */
+void QI2CTransport::registerFactory(const QString &prefix, Factory factory)
+{
+    QMutexLocker locker(&factoryMutex);
+    factories.insert(prefix, factory);
+}
+
+void QI2CTransport::unregisterFactory(const QString &prefix)
+{
+    QMutexLocker locker(&factoryMutex);
+    factories.remove(prefix);
+}
+
+/*!
+ * Creates the transport for \a path from the factory with the longest
+ * matching prefix, or an ioctl transport if none matches.
+ */
+QI2CTransport *QI2CTransport::create(const QString &path)
+{
+    QMutexLocker locker(&factoryMutex);
+
+    Factory factory;
+    auto match = factories.constEnd();
+
+    for(auto i = factories.constBegin(); i != factories.constEnd(); ++i)
+    {
+        if(path.startsWith(i.key()) && (match == factories.constEnd() || i.key().length() > match.key().length()))
+            match = i;
+    }
+
+    if(match != factories.constEnd())
+        factory = match.value();
+
+    //decorating factories create their inner transport recursively
+    locker.unlock();
+
+    if(factory)
+    {
+        QI2CTransport *transport = factory(path);
+
+        if(transport)
+            return transport;
+    }
+
+    return new QI2CIoctlTransport(path);
+}
+
+/*!
+ * Returns CLOCK_MONOTONIC in ns, the time base of all transports.
+ */
+quint64 QI2CTransport::timestamp()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (quint64)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+QI2CIoctlTransport::QI2CIoctlTransport(const QString &path)
+{
+    m_path = path;
+}
+
+QI2CIoctlTransport::~QI2CIoctlTransport()
+{
+    close();
+}
+
+bool QI2CIoctlTransport::open()
+{
+#ifdef Q_OS_LINUX
+    if(m_i2c >= 0)
+        return true;
+
+    m_i2c = ::open(m_path.toStdString().c_str(), O_RDWR);
+
+    return m_i2c >= 0;
+#else
+    errno = ENOSYS;
+    return false;
+#endif
+}
+
+bool QI2CIoctlTransport::close()
+{
+#ifdef Q_OS_LINUX
+    if(m_i2c < 0)
+        return true;
+
+    int result = ::close(m_i2c);
+    m_i2c = -1;
+
+    return result == 0;
+#else
+    return true;
+#endif
+}
+
+bool QI2CIoctlTransport::isOpen() const
+{
+    return m_i2c >= 0;
+}
+
+bool QI2CIoctlTransport::bind(quint16 address)
+{
+#ifdef Q_OS_LINUX
+    return ioctl(m_i2c, I2C_SLAVE, address) >= 0;
+#else
+    Q_UNUSED(address)
+    errno = ENOSYS;
+    return false;
+#endif
+}
+
+bool QI2CIoctlTransport::transfer(struct i2c_msg *messages, quint32 count)
+{
+#ifdef Q_OS_LINUX
+    struct i2c_rdwr_ioctl_data payload =
+    {
+        .msgs = messages,
+        .nmsgs = count
+    };
+
+    return ioctl(m_i2c, I2C_RDWR, &payload) >= 0;
+#else
+    Q_UNUSED(messages)
+    Q_UNUSED(count)
+    errno = ENOSYS;
+    return false;
+#endif
+}
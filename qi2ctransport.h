@@ -0,0 +1,78 @@
+#ifndef QI2CTRANSPORT_H
+#define QI2CTRANSPORT_H
+
+#include <QObject>
+#include <QString>
+#include <QMap>
+#include <QMutex>
+#include "qmpu6050_global.h"
+
+#include <functional>
+
+#ifdef Q_OS_LINUX
+#include "fcntl.h"
+#include "linux/i2c-dev.h"
+#include "linux/i2c.h"
+#include "linux/errno.h"
+#include "sys/ioctl.h"
+#endif
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Carrier of I2C_RDWR style message batches for one bus
+ *
+ * QI2CBus hands every transfer to its transport. The default transport is
+ * the Linux i2c-dev ioctl interface; other transports can be registered
+ * for bus paths starting with a given prefix, e.g. an in-process device
+ * emulator for "emulator:" paths.
+ *
+ * Transports report failures by returning false with errno set, just like
+ * the system calls they stand in for. They are only ever called with the
+ * bus mutex held.
+ */
+class QMPU6_5__EXPORT QI2CTransport
+{
+public:
+    typedef std::function<QI2CTransport*(const QString &path)> Factory;
+
+    virtual ~QI2CTransport() = default;
+
+    virtual bool open() = 0;
+    virtual bool close() = 0;
+    virtual bool isOpen() const = 0;
+
+    virtual bool bind(quint16 address) = 0;
+    virtual bool transfer(struct i2c_msg *messages, quint32 count) = 0;
+
+    static void registerFactory(const QString &prefix, Factory factory);
+    static void unregisterFactory(const QString &prefix);
+    static QI2CTransport *create(const QString &path);
+
+    static quint64 timestamp();
+};
+
+/*!
+ * \brief Transport over the Linux i2c-dev character device
+ */
+class QMPU6_5__EXPORT QI2CIoctlTransport : public QI2CTransport
+{
+    Q_DISABLE_COPY(QI2CIoctlTransport)
+public:
+    explicit QI2CIoctlTransport(const QString &path);
+    ~QI2CIoctlTransport();
+
+    virtual bool open() override;
+    virtual bool close() override;
+    virtual bool isOpen() const override;
+
+    virtual bool bind(quint16 address) override;
+    virtual bool transfer(struct i2c_msg *messages, quint32 count) override;
+
+private:
+    QString m_path;
+    int m_i2c = -1;
+};
+
+QT_END_NAMESPACE
+#endif // QI2CTRANSPORT_H
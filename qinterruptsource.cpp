@@ -0,0 +1,31 @@
+#include "qinterruptsource.h"
+
+#include <poll.h>
+#include <errno.h>
+
+/*!
+ * Blocks until an event is pending or \a timeout microseconds passed.
+ * Returns false on timeout or error.
+ */
+bool QInterruptSource::wait(quint64 timeout)
+{
+    struct pollfd descriptor =
+    {
+        .fd = handle(),
+        .events = POLLIN,
+        .revents = 0
+    };
+
+    struct timespec interval;
+    interval.tv_sec = timeout / 1000000;
+    interval.tv_nsec = (timeout % 1000000) * 1000;
+
+    int result;
+
+    while((result = ppoll(&descriptor, 1, &interval, nullptr)) < 0 && errno == EINTR);
+
+    if(result == 0)
+        errno = ETIMEDOUT;
+
+    return result > 0;
+}
@@ -0,0 +1,41 @@
+#ifndef QINTERRUPTSOURCE_H
+#define QINTERRUPTSOURCE_H
+
+#include <QtCore/qglobal.h>
+#include "qmpu6050_global.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Source of hardware interrupt events exposed as a pollable fd
+ *
+ * The acquisition engine waits for handle() to become readable, then takes
+ * the pending events with read(). Events carry the CLOCK_MONOTONIC time the
+ * edge was seen, so samples can be stamped with the time the chip raised
+ * its interrupt rather than the time the thread got around to it.
+ *
+ * Like transports, sources fail by returning false or -1 with errno set.
+ */
+class QMPU6_5__EXPORT QInterruptSource
+{
+public:
+    struct Event
+    {
+        quint64 timestamp = 0; //CLOCK_MONOTONIC in ns
+        quint32 sequence = 0;
+    };
+
+    virtual ~QInterruptSource() = default;
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+
+    virtual int handle() const = 0;
+    virtual int read(Event *events, int maximum) = 0;
+
+    bool wait(quint64 timeout);
+};
+
+QT_END_NAMESPACE
+#endif // QINTERRUPTSOURCE_H
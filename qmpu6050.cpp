@@ -1,13 +1,129 @@
 #include "qmpu6050.h"
 #include "qmpu6050backend.h"
 
-QMPU6050::QMPU6050(QObject *parent) : QSensor(sensorType, parent) {}
+QMPU6050::QMPU6050(QObject *parent) : QSensor(sensorType, parent)
+{
+    m_frames = new QSPSCQueue<QMPU6050Frame, 4096>;
+
+    m_propertyTimer = new QTimer(this);
+    m_propertyTimer->setInterval(qRound(1000 / m_propertyUpdateRate));
+    QObject::connect(m_propertyTimer, &QTimer::timeout, this, &QMPU6050::updateProperties);
+}
+
+QMPU6050::~QMPU6050()
+{
+    delete m_frames;
+}
 
 QAccelerometerReading *QMPU6050::reading() const
 {
     return qobject_cast<QAccelerometerReading*>(QSensor::reading());
 }
 
+/*!
+ * Takes the oldest buffered frame without blocking. Returns false if no frame
+ * is waiting. Unlike reading(), which only ever holds the latest sample, every
+ * frame delivered by the backend stays buffered until it is read or the
+ * buffer overruns.
+ */
+bool QMPU6050::readFrame(QMPU6050Frame *frame)
+{
+    return m_frames->pop(frame);
+}
+
+/*!
+ * Takes up to \a maximum buffered frames into \a frames without blocking and
+ * returns how many were taken. May be called from any one consumer thread.
+ */
+qsizetype QMPU6050::readFrames(QMPU6050Frame *frames, qsizetype maximum)
+{
+    if(maximum <= 0)
+        return 0;
+
+    return m_frames->pop(frames, static_cast<quint32>(qMin<qsizetype>(maximum, m_frames->capacity())));
+}
+
+/*!
+ * Returns the full-rate broadcast ring of the chip this sensor is connected
+ * to, or nullptr before a backend is connected. The ring belongs to the
+ * acquisition engine and changes when the bus or address changes.
+ */
+QMPU6050FrameRing *QMPU6050::frameRing() const
+{
+    if(!m_controller || !m_controller->acquisition())
+        return nullptr;
+
+    return m_controller->acquisition()->frameRing();
+}
+
+/*!
+ * Returns a snapshot of the bus traffic of the chip: transactions, bytes and
+ * failures by errno, latency histograms per operation type, bus utilization
+ * and reopen counts. Empty before a backend is connected.
+ */
+QI2CStatistics QMPU6050::statistics() const
+{
+    if(!m_controller)
+        return QI2CStatistics();
+
+    return m_controller->statistics();
+}
+
+void QMPU6050::resetStatistics()
+{
+    if(m_controller)
+        m_controller->resetStatistics();
+}
+
+/*!
+ * Returns where the fault handling of the chip stands. Errors it could not
+ * recover from are also reported through sensorError().
+ */
+QMPU6050Acquisition::FaultState QMPU6050::faultState() const
+{
+    if(!m_controller || !m_controller->acquisition())
+        return QMPU6050Acquisition::HealthyState;
+
+    return m_controller->acquisition()->faultState();
+}
+
+/*!
+ * Returns the retry, reopen, reinitialization and recovery counters of the
+ * chip's acquisition engine.
+ */
+QMPU6050Acquisition::FaultStatistics QMPU6050::faultStatistics() const
+{
+    if(!m_controller || !m_controller->acquisition())
+        return QMPU6050Acquisition::FaultStatistics();
+
+    return m_controller->acquisition()->faultStatistics();
+}
+
+/*!
+ * Returns the tracking state of the chip's sample clock, including its
+ * drift against CLOCK_MONOTONIC in ppm.
+ */
+QMPU6050Timestamper QMPU6050::timestamper() const
+{
+    if(!m_controller || !m_controller->acquisition())
+        return QMPU6050Timestamper();
+
+    return m_controller->acquisition()->timestamper();
+}
+
+qsizetype QMPU6050::framesAvailable() const
+{
+    return m_frames->count();
+}
+
+/*!
+ * Number of frames dropped because the buffer was full when they arrived.
+ */
+quint64 QMPU6050::frameOverrunCount() const
+{
+    return m_frames->overrunCount();
+}
+
 bool QMPU6050::initialize()
 {
     if(m_controller)
@@ -16,6 +132,30 @@ bool QMPU6050::initialize()
     return false;
 }
 
+/*!
+ * Reads the whole configuration of the chip in a few burst transfers and
+ * updates every configuration property from it, emitting changed signals
+ * only for the properties that differ. Until invalidateConfiguration() is
+ * called the configuration is served from this snapshot.
+ */
+bool QMPU6050::refreshConfiguration()
+{
+    if(m_controller)
+        return m_controller->refreshConfiguration();
+
+    return false;
+}
+
+/*!
+ * Drops the configuration snapshot, the next read goes to the chip. Use it
+ * when the configuration was changed behind the plugin's back.
+ */
+void QMPU6050::invalidateConfiguration()
+{
+    if(m_controller)
+        m_controller->invalidateConfiguration();
+}
+
 QString QMPU6050::bus() const
 {
     return m_bus;
@@ -1014,3 +1154,178 @@ void QMPU6050::setGyroscopeRateDivider(quint8 gyroscopeRateDivider)
         emit gyroscopeRateDividerChanged();
     }
 }
+
+bool QMPU6050::isFIFOStreaming() const
+{
+    return m_fifoStreaming;
+}
+
+void QMPU6050::setFIFOStreaming(bool fifoStreaming)
+{
+    if (m_fifoStreaming == fifoStreaming)
+        return;
+
+    m_fifoStreaming = fifoStreaming;
+
+    if(controller())
+        controller()->setFIFOStreaming(fifoStreaming);
+
+    emit fifoStreamingChanged();
+}
+
+/*!
+ * Returns how often, in Hz, the per-channel properties such as xAcceleration
+ * are refreshed. 0 refreshes them with every sample.
+ */
+qreal QMPU6050::propertyUpdateRate() const
+{
+    return m_propertyUpdateRate;
+}
+
+/*!
+ * Limits the per-channel property notifications to \a propertyUpdateRate Hz,
+ * enough for bindings that only display values. Consumers of every sample
+ * should use frameUpdated(), which carries all channels at once.
+ */
+void QMPU6050::setPropertyUpdateRate(qreal propertyUpdateRate)
+{
+    propertyUpdateRate = qMax<qreal>(0, propertyUpdateRate);
+
+    if (m_propertyUpdateRate == propertyUpdateRate)
+        return;
+
+    m_propertyUpdateRate = propertyUpdateRate;
+
+    if(m_propertyUpdateRate > 0)
+        m_propertyTimer->setInterval(qMax(1, qRound(1000 / m_propertyUpdateRate)));
+    else
+    {
+        m_propertyTimer->stop();
+        updateProperties();
+    }
+
+    emit propertyUpdateRateChanged();
+}
+
+/*!
+ * Takes one sample from the backend: announces it with frameUpdated() and
+ * queues its channels for the throttled property update.
+ */
+void QMPU6050::updateFrame(const QMPU6050Frame &frame)
+{
+    emit frameUpdated(frame);
+
+    for(int i = 0; i < 3; ++i)
+    {
+        m_pendingChannels[i] = frame.rawAcceleration[i];
+        m_pendingChannels[4 + i] = frame.rawRotation[i];
+    }
+
+    m_pendingChannels[3] = frame.rawTemperature;
+
+    schedulePropertyUpdate();
+}
+
+void QMPU6050::setPendingAcceleration(qint16 x, qint16 y, qint16 z)
+{
+    m_pendingChannels[0] = x;
+    m_pendingChannels[1] = y;
+    m_pendingChannels[2] = z;
+
+    schedulePropertyUpdate();
+}
+
+void QMPU6050::setPendingTemperature(qint16 temperature)
+{
+    m_pendingChannels[3] = temperature;
+
+    schedulePropertyUpdate();
+}
+
+void QMPU6050::setPendingRotation(qint16 x, qint16 y, qint16 z)
+{
+    m_pendingChannels[4] = x;
+    m_pendingChannels[5] = y;
+    m_pendingChannels[6] = z;
+
+    schedulePropertyUpdate();
+}
+
+/*!
+ * Refreshes the properties right away when the last refresh is at least one
+ * interval ago, otherwise once the interval is over. Values arriving in
+ * between are coalesced into that one refresh.
+ */
+void QMPU6050::schedulePropertyUpdate()
+{
+    m_channelsPending = true;
+
+    if(m_propertyUpdateRate <= 0)
+    {
+        updateProperties();
+        return;
+    }
+
+    if(m_propertyTimer->isActive())
+        return;
+
+    updateProperties();
+    m_propertyTimer->start();
+}
+
+/*!
+ * Copies the pending channel values into the properties and notifies the
+ * ones that changed. The timer stops once an interval passed without data.
+ */
+void QMPU6050::updateProperties()
+{
+    if(!m_channelsPending)
+    {
+        m_propertyTimer->stop();
+        return;
+    }
+
+    m_channelsPending = false;
+
+    if(m_xAcceleration != m_pendingChannels[0])
+    {
+        m_xAcceleration = m_pendingChannels[0];
+        emit xAccelerationChanged();
+    }
+
+    if(m_yAcceleration != m_pendingChannels[1])
+    {
+        m_yAcceleration = m_pendingChannels[1];
+        emit yAccelerationChanged();
+    }
+
+    if(m_zAcceleration != m_pendingChannels[2])
+    {
+        m_zAcceleration = m_pendingChannels[2];
+        emit zAccelerationChanged();
+    }
+
+    if(m_temperature != m_pendingChannels[3])
+    {
+        m_temperature = m_pendingChannels[3];
+        emit temperatureChanged();
+    }
+
+    if(m_xRotation != m_pendingChannels[4])
+    {
+        m_xRotation = m_pendingChannels[4];
+        emit xRotationChanged();
+    }
+
+    if(m_yRotation != m_pendingChannels[5])
+    {
+        m_yRotation = m_pendingChannels[5];
+        emit yRotationChanged();
+    }
+
+    if(m_zRotation != m_pendingChannels[6])
+    {
+        m_zRotation = m_pendingChannels[6];
+        emit zRotationChanged();
+    }
+}
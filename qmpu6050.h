@@ -6,8 +6,13 @@
 #include <QSensor>
 #include <QString>
 #include <QAccelerometerReading>
+#include <QTimer>
 
 #include "qmpu6050_global.h"
+#include "qmpu6050batch.h"
+#include "qspscqueue.h"
+#include "qi2cstatistics.h"
+#include "qmpu6050acquisition.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -88,11 +93,30 @@ public:
     Q_ENUM(ExternalFrameSync)
 
     explicit QMPU6050(QObject *parent = nullptr);
+    ~QMPU6050();
 
     QAccelerometerReading *reading() const;
 
+    bool readFrame(QMPU6050Frame *frame);
+    qsizetype readFrames(QMPU6050Frame *frames, qsizetype maximum);
+    qsizetype framesAvailable() const;
+    quint64 frameOverrunCount() const;
+
+    QMPU6050FrameRing *frameRing() const;
+
+    QI2CStatistics statistics() const;
+    void resetStatistics();
+
+    QMPU6050Acquisition::FaultState faultState() const;
+    QMPU6050Acquisition::FaultStatistics faultStatistics() const;
+
+    QMPU6050Timestamper timestamper() const;
+
     bool initialize();
 
+    bool refreshConfiguration();
+    void invalidateConfiguration();
+
     QString bus() const;
     void setBus(const QString &bus);
 
@@ -294,6 +318,12 @@ public:
     quint8 gyroscopeRateDivider() const;
     void setGyroscopeRateDivider(quint8 gyroscopeRateDivider);
 
+    bool isFIFOStreaming() const;
+    void setFIFOStreaming(bool fifoStreaming);
+
+    qreal propertyUpdateRate() const;
+    void setPropertyUpdateRate(qreal propertyUpdateRate);
+
 signals:
     void busChanged();
     void addressChanged();
@@ -440,9 +470,23 @@ signals:
 
     void gyroscopeRateDividerChanged();
 
+    void fifoStreamingChanged();
+
+    //every sample of one poll or FIFO drain, emitted once per wakeup
+    void batchReady(const QMPU6050Batch &batch);
+
+    //every channel of one sample, emitted for every sample the chip is
+    //acquired at, independent of dataRate, while floating point output is on
+    void frameUpdated(const QMPU6050Frame &frame);
+
+    void propertyUpdateRateChanged();
+
 private:
     QMPU6050Backend *m_controller = nullptr;
 
+    //decoded frames waiting for readFrames(), written by the backend only
+    QSPSCQueue<QMPU6050Frame, 4096> *m_frames = nullptr;
+
     QString m_bus = "/dev/i2c-1"; //i2c bus path
     quint8 m_address = 0x68; //i2c device address
 
@@ -546,6 +590,21 @@ private:
 
     quint8 m_gyroscopeRateDivider = 1;
 
+    bool m_fifoStreaming = false; //sample through the chip FIFO instead of polling
+
+    //the per-channel properties are refreshed at most this often, in Hz
+    qreal m_propertyUpdateRate = 30;
+    QTimer *m_propertyTimer = nullptr;
+    qint16 m_pendingChannels[7] = { 0, 0, 0, 0, 0, 0, 0 };
+    bool m_channelsPending = false;
+
+    void updateFrame(const QMPU6050Frame &frame);
+    void setPendingAcceleration(qint16 x, qint16 y, qint16 z);
+    void setPendingTemperature(qint16 temperature);
+    void setPendingRotation(qint16 x, qint16 y, qint16 z);
+    void schedulePropertyUpdate();
+    void updateProperties();
+
     Q_PROPERTY(QString bus READ bus WRITE setBus NOTIFY busChanged FINAL)
     Q_PROPERTY(quint8 address READ address WRITE setAddress NOTIFY addressChanged FINAL)
     Q_PROPERTY(quint8 dmpConfig1 READ dmpConfig1 WRITE setDmpConfig1 NOTIFY dmpConfig1Changed FINAL)
@@ -619,6 +678,8 @@ private:
     Q_PROPERTY(DLPFilterMode dlpFilterMode READ dlpFilterMode WRITE setDlpFilterMode NOTIFY dlpFilterModeChanged FINAL)
     Q_PROPERTY(ExternalFrameSync externalFrameSync READ externalFrameSync WRITE setExternalFrameSync NOTIFY externalFrameSyncChanged FINAL)
     Q_PROPERTY(quint8 gyroscopeRateDivider READ gyroscopeRateDivider WRITE setGyroscopeRateDivider NOTIFY gyroscopeRateDividerChanged FINAL)
+    Q_PROPERTY(bool isFIFOStreaming READ isFIFOStreaming WRITE setFIFOStreaming NOTIFY fifoStreamingChanged FINAL)
+    Q_PROPERTY(qreal propertyUpdateRate READ propertyUpdateRate WRITE setPropertyUpdateRate NOTIFY propertyUpdateRateChanged FINAL)
 };
 
 Q_DECLARE_METATYPE(QMPU6050)
@@ -352,6 +352,9 @@
 #define MPU6050_WHO_AM_I_BIT        6
 #define MPU6050_WHO_AM_I_LENGTH     6
 
+#define MPU6050_FIFO_SIZE               1024
+#define MPU6050_RA_I2C_SLV_CTRL_STRIDE  3
+
 #define MPU6050_DMP_MEMORY_BANKS        8
 #define MPU6050_DMP_MEMORY_BANK_SIZE    256
 #define MPU6050_DMP_MEMORY_CHUNK_SIZE   16
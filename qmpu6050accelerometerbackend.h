@@ -13,10 +13,10 @@
 #include <QObject>
 
 #include "qmpu6050backend.h"
-#include "qi2cdevice.h"
+#include "qmpu6050acquisition.h"
 #include "qmpu6050_p.h"
 
-class QMPU6050AccelerometerBackend : public QSensorBackend
+class QMPU6050AccelerometerBackend : public QSensorBackend, public QMPU6050FrameListener
 {
     Q_OBJECT
 public:
@@ -29,19 +29,21 @@ public:
     virtual void start() override;
     virtual void stop() override;
 
+    virtual void frameReceived(const QMPU6050Frame &frame) override;
+
 private slots:
-    void poll();
     void handleFault();
+    void handleError(int error);
     void reportEvent(QString message);
     void reportError(QString message);
     void onSensorDataRateChanged();
 
 private:
-    QTimer *m_pollTimer = nullptr;
     QAccelerometerReading m_reading;
     QMPU6050Backend *m_backend = nullptr;
-    QI2CDevice *m_i2c = nullptr;
+    QMPU6050Acquisition *m_acquisition = nullptr;
     bool m_backendDebug = false;
+    bool m_fifoStreaming = false;
 };
 
 #endif // QMPU6_5_ACCELEROMETERBACKEND_H
@@ -0,0 +1,2030 @@
+#include "qmpu6050acquisition.h"
+#include "qgpiointerruptsource.h"
+
+#include <QVarLengthArray>
+
+#include <time.h>
+
+//registry of engines keyed by "bus:address"
+static QMutex registryMutex;
+static QHash<QString, QMPU6050Acquisition*> registry;
+
+//the millisecond poll timer cannot keep up beyond this
+static const qreal pollingRateLimit = 157;
+
+//gyroscope output rate with the DLPF enabled and disabled, accel is fixed at 1 kHz
+static const qreal gyroscopeRate = 1000;
+static const qreal gyroscopeRateUnfiltered = 8000;
+
+//DLPF bandwidths in Hz indexed by DLPF_CFG 1..6
+static const qreal dlpfBandwidth[] = { 188, 98, 42, 20, 10, 5 };
+
+//upper bound in milliseconds for the time between two FIFO drains
+static const int drainIntervalLimit = 20;
+
+//consecutive drains with the same partial packet before the FIFO is
+//considered misaligned
+static const quint32 misalignmentLimit = 3;
+
+//microseconds between recovery attempts once recovery has failed
+static const quint64 recoveryInterval = 1000000;
+
+//microseconds a chip needs after DEVICE_RESET or a brown-out before it
+//takes its configuration again
+static const quint64 resetDelay = 100000;
+
+static QString registryKey(const QString &bus, quint8 address)
+{
+    return QString("%1:%2").arg(bus).arg(address, 2, 16, '0');
+}
+
+QMPU6050Acquisition::QMPU6050Acquisition(const QString &bus, quint8 address)
+    : QObject{nullptr}
+{
+    m_bus = bus;
+    m_address = address;
+
+    m_i2c = new QI2CDevice(bus, address);
+    configureRegisterShadow(m_i2c);
+
+    m_pollTimer = new QTimer(this);
+    m_pollTimer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(m_pollTimer, SIGNAL(timeout()), this, SLOT(poll()));
+}
+
+QMPU6050Acquisition::~QMPU6050Acquisition()
+{
+    if(m_pollTimer->isActive())
+        m_pollTimer->stop();
+
+    //the thread must be done with this engine before it goes away
+    if(m_thread)
+    {
+        m_thread->remove(this);
+        QMPU6050AcquisitionThread::release(m_thread);
+        m_thread = nullptr;
+    }
+
+    if(m_fifoActive)
+        disableFIFO();
+
+    if(m_interruptActive)
+        disableInterrupt();
+
+    delete m_interrupt;
+    delete m_i2c;
+}
+
+QMPU6050Acquisition *QMPU6050Acquisition::acquire(const QString &bus, quint8 address)
+{
+    QMutexLocker locker(&registryMutex);
+
+    QString key = registryKey(bus, address);
+    QMPU6050Acquisition *acquisition = registry.value(key, nullptr);
+
+    if(!acquisition)
+    {
+        acquisition = new QMPU6050Acquisition(bus, address);
+        registry.insert(key, acquisition);
+    }
+
+    ++acquisition->m_refCount;
+
+    return acquisition;
+}
+
+void QMPU6050Acquisition::release(QMPU6050Acquisition *acquisition)
+{
+    if(!acquisition)
+        return;
+
+    QMutexLocker locker(&registryMutex);
+
+    if(--acquisition->m_refCount > 0)
+        return;
+
+    registry.remove(registryKey(acquisition->m_bus, acquisition->m_address));
+    delete acquisition;
+}
+
+/*!
+ * Starts delivering frames to \a listener at \a rate Hz. The engine starts
+ * sampling when the first listener is attached. \a sources names the channels
+ * the listener reads, only those are routed into the FIFO in FIFOMode.
+ */
+void QMPU6050Acquisition::attach(QMPU6050FrameListener *listener, qreal rate, Sources sources, Mode mode)
+{
+    if(!listener)
+        return;
+
+    if(isAttached(listener))
+    {
+        for(Listener &entry : m_listeners)
+        {
+            if(entry.listener != listener)
+                continue;
+
+            entry.rate = qMax<qreal>(rate, 1);
+            entry.sources = sources;
+            entry.mode = mode;
+        }
+
+        updateInterval();
+        return;
+    }
+
+    Listener entry;
+    entry.listener = listener;
+    entry.rate = qMax<qreal>(rate, 1);
+    entry.sources = sources;
+    entry.mode = mode;
+
+    m_listeners.append(entry);
+    updateInterval();
+}
+
+void QMPU6050Acquisition::detach(QMPU6050FrameListener *listener)
+{
+    for(qsizetype i = 0; i < m_listeners.count(); ++i)
+    {
+        if(m_listeners[i].listener == listener)
+        {
+            m_listeners.removeAt(i);
+            break;
+        }
+    }
+
+    updateInterval();
+}
+
+void QMPU6050Acquisition::setRate(QMPU6050FrameListener *listener, qreal rate)
+{
+    for(Listener &entry : m_listeners)
+    {
+        if(entry.listener == listener)
+            entry.rate = qMax<qreal>(rate, 1);
+    }
+
+    updateInterval();
+}
+
+/*!
+ * Requests \a mode for \a listener. The engine streams from the FIFO as soon
+ * as one attached listener asks for FIFOMode.
+ */
+void QMPU6050Acquisition::setMode(QMPU6050FrameListener *listener, Mode mode)
+{
+    for(Listener &entry : m_listeners)
+    {
+        if(entry.listener == listener)
+            entry.mode = mode;
+    }
+
+    updateInterval();
+}
+
+/*!
+ * Makes \a listener receive QMPU6050FixedFrame through fixedFrameReceived()
+ * instead of QMPU6050Frame. Once every listener asked for FixedPointOutput
+ * samples are no longer converted to floating point and no batches are
+ * delivered.
+ */
+void QMPU6050Acquisition::setOutputFormat(QMPU6050FrameListener *listener, OutputFormat format)
+{
+    for(Listener &entry : m_listeners)
+    {
+        if(entry.listener == listener)
+            entry.format = format;
+    }
+
+    updateInterval();
+}
+
+bool QMPU6050Acquisition::isAttached(QMPU6050FrameListener *listener) const
+{
+    for(const Listener &entry : m_listeners)
+    {
+        if(entry.listener == listener)
+            return true;
+    }
+
+    return false;
+}
+
+qreal QMPU6050Acquisition::rate() const
+{
+    return m_rate;
+}
+
+/*!
+ * Returns true while the engine samples the chip, i.e. while at least one
+ * listener is attached and the chip took its sampling setup.
+ */
+bool QMPU6050Acquisition::isActive() const
+{
+    return m_interval != 0;
+}
+
+QMPU6050Acquisition::Mode QMPU6050Acquisition::mode() const
+{
+    return m_mode;
+}
+
+QMPU6050Acquisition::Sources QMPU6050Acquisition::sources() const
+{
+    return m_sources;
+}
+
+/*!
+ * Returns whether samples are converted to floating point, i.e. whether some
+ * listener asked for FloatingPointOutput.
+ */
+bool QMPU6050Acquisition::isFloatingPoint() const
+{
+    return m_floatingPoint;
+}
+
+quint16 QMPU6050Acquisition::packetSize() const
+{
+    return m_packetSize;
+}
+
+/*!
+ * Returns the highest sample rate in Hz reachable in \a mode with \a sources
+ * enabled. Only gyroscope-only FIFO streaming may exceed the 1 kHz
+ * accelerometer output rate.
+ */
+qreal QMPU6050Acquisition::maximumRate(Mode mode, Sources sources)
+{
+    if(mode == PollingMode)
+        return pollingRateLimit;
+
+    if(sources == Gyroscope)
+        return gyroscopeRateUnfiltered;
+
+    return gyroscopeRate;
+}
+
+/*!
+ * Returns the size in bytes of one FIFO packet holding \a sources.
+ */
+quint16 QMPU6050Acquisition::packetSize(Sources sources)
+{
+    quint16 size = 0;
+
+    if(sources & Accelerometer)
+        size += 6;
+    if(sources & Temperature)
+        size += 2;
+    if(sources & Gyroscope)
+        size += 6;
+
+    return size;
+}
+
+QString QMPU6050Acquisition::bus() const
+{
+    return m_bus;
+}
+
+quint8 QMPU6050Acquisition::address() const
+{
+    return m_address;
+}
+
+QI2CDevice *QMPU6050Acquisition::device() const
+{
+    return m_i2c;
+}
+
+/*!
+ * Number of frames dropped because the consumer thread fell a whole queue
+ * behind the sampling thread.
+ */
+quint64 QMPU6050Acquisition::overrunCount() const
+{
+    return m_queue.overrunCount();
+}
+
+/*!
+ * Returns the broadcast ring the engine publishes every decoded frame into,
+ * at the full engine rate and before any decimation. Readers take their own
+ * cursor with QMPU6050FrameRing::reader() and may read from any thread.
+ */
+QMPU6050FrameRing *QMPU6050Acquisition::frameRing()
+{
+    return &m_frameRing;
+}
+
+QMPU6050Frame QMPU6050Acquisition::lastFrame() const
+{
+    return m_frame;
+}
+
+QMPU6050Batch QMPU6050Acquisition::lastBatch() const
+{
+    return *m_batch;
+}
+
+/*!
+ * Describes the MPU6050 register map to the shadow of \a device: the
+ * configuration registers are shadowed, status, data, FIFO and DMP memory
+ * ports are volatile, and reset and trigger bits clear themselves.
+ */
+void QMPU6050Acquisition::configureRegisterShadow(QI2CDevice *device)
+{
+    QMutexLocker locker(device->handle() ? device->handle()->mutex() : nullptr);
+    QI2CRegisterShadow *shadow = device->shadow();
+
+    if(shadow->isConfigured())
+        return;
+
+    shadow->setCacheable(MPU6050_RA_XG_OFFS_TC, MPU6050_RA_WHO_AM_I);
+
+    shadow->setVolatile(MPU6050_RA_I2C_SLV4_DI, MPU6050_RA_I2C_MST_STATUS);
+    shadow->setVolatile(MPU6050_RA_DMP_INT_STATUS, MPU6050_RA_MOT_DETECT_STATUS);
+    shadow->setVolatile(MPU6050_RA_MEM_START_ADDR, MPU6050_RA_MEM_R_W);
+    shadow->setVolatile(MPU6050_RA_FIFO_COUNTH, MPU6050_RA_FIFO_R_W);
+
+    shadow->setSelfClearing(MPU6050_RA_I2C_SLV4_CTRL, 1 << MPU6050_I2C_SLV4_EN_BIT);
+    shadow->setSelfClearing(MPU6050_RA_SIGNAL_PATH_RESET, (1 << MPU6050_PATHRESET_GYRO_RESET_BIT) | (1 << MPU6050_PATHRESET_ACCEL_RESET_BIT) | (1 << MPU6050_PATHRESET_TEMP_RESET_BIT));
+    shadow->setSelfClearing(MPU6050_RA_USER_CTRL, (1 << MPU6050_USERCTRL_DMP_RESET_BIT) | (1 << MPU6050_USERCTRL_FIFO_RESET_BIT) | (1 << MPU6050_USERCTRL_I2C_MST_RESET_BIT) | (1 << MPU6050_USERCTRL_SIG_COND_RESET_BIT));
+    shadow->setSelfClearing(MPU6050_RA_PWR_MGMT_1, 1 << MPU6050_PWR1_DEVICE_RESET_BIT);
+}
+
+/*!
+ * Returns the current CLOCK_MONOTONIC time in microseconds.
+ */
+quint64 QMPU6050Acquisition::timestamp()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<quint64>(now.tv_sec) * 1000000 + static_cast<quint64>(now.tv_nsec) / 1000;
+}
+
+/*!
+ * Decodes a 14 byte ACCEL_XOUT_H..GYRO_ZOUT_L burst into \a frame.
+ */
+void QMPU6050Acquisition::decode(const quint8 *buffer, QMPU6050Frame *frame, const QMPU6050Decoder::Scale &scale)
+{
+    decode(buffer, AllSources, frame, scale);
+}
+
+/*!
+ * Decodes one FIFO packet holding \a sources into \a frame. The FIFO stores
+ * the channels in register order; channels not in \a sources keep their
+ * previous value. \a scale has to match the configured full scale ranges.
+ */
+void QMPU6050Acquisition::decode(const quint8 *buffer, Sources sources, QMPU6050Frame *frame, const QMPU6050Decoder::Scale &scale)
+{
+    if(sources & Accelerometer)
+    {
+        for(int i = 0; i < 3; ++i)
+        {
+            frame->rawAcceleration[i] = static_cast<qint16>((buffer[i * 2] << 8) | buffer[i * 2 + 1]);
+            frame->acceleration[i] = frame->rawAcceleration[i] * scale.acceleration;
+        }
+
+        buffer += 6;
+    }
+
+    if(sources & Temperature)
+    {
+        frame->rawTemperature = static_cast<qint16>((buffer[0] << 8) | buffer[1]);
+        frame->temperature = frame->rawTemperature * scale.temperature + scale.temperatureOffset;
+
+        buffer += 2;
+    }
+
+    if(sources & Gyroscope)
+    {
+        for(int i = 0; i < 3; ++i)
+        {
+            frame->rawRotation[i] = static_cast<qint16>((buffer[i * 2] << 8) | buffer[i * 2 + 1]);
+            frame->rotation[i] = frame->rawRotation[i] * scale.rotation;
+        }
+    }
+}
+
+/*!
+ * Like decode() but only fills in the raw values.
+ */
+void QMPU6050Acquisition::decodeRaw(const quint8 *buffer, Sources sources, QMPU6050Frame *frame)
+{
+    if(sources & Accelerometer)
+    {
+        for(int i = 0; i < 3; ++i)
+            frame->rawAcceleration[i] = static_cast<qint16>((buffer[i * 2] << 8) | buffer[i * 2 + 1]);
+
+        buffer += 6;
+    }
+
+    if(sources & Temperature)
+    {
+        frame->rawTemperature = static_cast<qint16>((buffer[0] << 8) | buffer[1]);
+        buffer += 2;
+    }
+
+    if(sources & Gyroscope)
+    {
+        for(int i = 0; i < 3; ++i)
+            frame->rawRotation[i] = static_cast<qint16>((buffer[i * 2] << 8) | buffer[i * 2 + 1]);
+    }
+}
+
+QMPU6050FixedFrame QMPU6050Acquisition::fixedFrame(const QMPU6050Frame &frame)
+{
+    QMPU6050FixedFrame fixed;
+
+    fixed.timestamp = frame.timestamp;
+    fixed.gap = frame.gap;
+    fixed.temperature = frame.rawTemperature;
+    fixed.accelerationRange = frame.accelerationRange;
+    fixed.rotationRange = frame.rotationRange;
+
+    for(int i = 0; i < 3; ++i)
+    {
+        fixed.acceleration[i] = frame.rawAcceleration[i];
+        fixed.rotation[i] = frame.rawRotation[i];
+    }
+
+    return fixed;
+}
+
+/*!
+ * Picks the conversion factors for the full scale ranges the chip is
+ * configured for, from the register shadow when it knows them. Runs where
+ * sampling runs.
+ */
+bool QMPU6050Acquisition::updateScale()
+{
+    quint8 config[2];
+
+    if(!m_i2c->start())
+        return false;
+
+    //GYRO_CONFIG and ACCEL_CONFIG are adjacent
+    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_GYRO_CONFIG), config, 2))
+    {
+        int error = errno;
+        m_i2c->end();
+        errno = error;
+        return false;
+    }
+
+    m_i2c->end();
+
+    quint8 gyroRange = (config[0] >> (MPU6050_GCONFIG_FS_SEL_BIT - MPU6050_GCONFIG_FS_SEL_LENGTH + 1)) & 0x03;
+    quint8 accelRange = (config[1] >> (MPU6050_ACONFIG_AFS_SEL_BIT - MPU6050_ACONFIG_AFS_SEL_LENGTH + 1)) & 0x03;
+
+    m_scale.storeRelease(QMPU6050Decoder::nativeScale(accelRange, gyroRange));
+
+    return true;
+}
+
+/*!
+ * Switches the accelerometer conversion to AFS_SEL \a range. Call it after
+ * writing ACCEL_CONFIG; frames decoded afterwards use the new factor. Safe
+ * to call from any thread.
+ */
+void QMPU6050Acquisition::setAccelerometerRange(quint8 range)
+{
+    const QMPU6050Decoder::Scale *current;
+
+    do
+        current = m_scale.loadAcquire();
+    while(!m_scale.testAndSetOrdered(current, QMPU6050Decoder::nativeScale(range, QMPU6050Decoder::rotationRange(current))));
+}
+
+/*!
+ * Switches the gyroscope conversion to FS_SEL \a range, see
+ * setAccelerometerRange().
+ */
+void QMPU6050Acquisition::setGyroscopeRange(quint8 range)
+{
+    const QMPU6050Decoder::Scale *current;
+
+    do
+        current = m_scale.loadAcquire();
+    while(!m_scale.testAndSetOrdered(current, QMPU6050Decoder::nativeScale(QMPU6050Decoder::accelerationRange(current), range)));
+}
+
+/*!
+ * Returns the conversion factors frames are currently decoded with.
+ */
+const QMPU6050Decoder::Scale *QMPU6050Acquisition::scale() const
+{
+    return m_scale.loadAcquire();
+}
+
+/*!
+ * Copies packet \a index of the last block decode into \a frame.
+ */
+void QMPU6050Acquisition::decoded(quint16 index, QMPU6050Frame *frame) const
+{
+    for(int i = 0; i < 3; ++i)
+    {
+        frame->rawAcceleration[i] = m_decodedRaw[QMPU6050Decoder::AccelerationX + i][index];
+        frame->acceleration[i] = m_decodedValues[QMPU6050Decoder::AccelerationX + i][index];
+        frame->rawRotation[i] = m_decodedRaw[QMPU6050Decoder::RotationX + i][index];
+        frame->rotation[i] = m_decodedValues[QMPU6050Decoder::RotationX + i][index];
+    }
+
+    if(m_sources & Temperature)
+    {
+        frame->rawTemperature = m_decodedRaw[QMPU6050Decoder::Temperature][index];
+        frame->temperature = m_decodedValues[QMPU6050Decoder::Temperature][index];
+    }
+}
+
+/*!
+ * Timer driven sampling on the consumer thread.
+ */
+void QMPU6050Acquisition::poll()
+{
+    sampleOnTimeout();
+    dispatch();
+}
+
+/*!
+ * Interrupt driven sampling on the consumer thread.
+ */
+void QMPU6050Acquisition::interrupted()
+{
+    serviceInterrupt();
+    dispatch();
+}
+
+/*!
+ * Performs one sampling cycle and queues the decoded frames for dispatch().
+ * Runs on the acquisition thread when threaded, otherwise from poll().
+ */
+bool QMPU6050Acquisition::sample()
+{
+    //recovery advances one stage per cycle once the stage is due
+    if(m_faultState.loadRelaxed() != HealthyState)
+    {
+        if(timestamp() < m_nextRecovery)
+            return false;
+
+        return recover();
+    }
+
+    //a backend hit an error on its own accesses or reset the chip
+    if(int requested = m_recoveryRequested.fetchAndStoreOrdered(0))
+    {
+        switch(requested)
+        {
+        case EBADF:
+        case ENODEV:
+            //the adapter went away, retrying on the same fd is pointless
+            ++m_faults.faults;
+            return escalate(ReopeningState, requested, 0);
+
+        case ESTALE:
+            //the chip lost its configuration, restore it once it is back
+            ++m_faults.faults;
+            return escalate(ReinitializingState, requested, timestamp() + resetDelay);
+
+        default:
+            if(!verify())
+                return fault(errno);
+
+            break;
+        }
+    }
+
+    if(readSamples())
+        return true;
+
+    return fault(errno);
+}
+
+/*!
+ * Samples when the interval elapsed. While interrupts arrive in time this
+ * is only a watchdog and leaves sampling to serviceInterrupt().
+ */
+bool QMPU6050Acquisition::sampleOnTimeout()
+{
+    if(m_interruptActive)
+    {
+        if(timestamp() - m_lastInterrupt < m_interval)
+            return true;
+
+        ++m_interruptTimeoutCount;
+        m_pendingInterrupts = 0;
+    }
+
+    return sample();
+}
+
+/*!
+ * Takes the pending edges of the interrupt source and samples once enough
+ * of them arrived: every edge in PollingMode, one drain interval worth in
+ * FIFOMode.
+ */
+bool QMPU6050Acquisition::serviceInterrupt()
+{
+    QInterruptSource::Event events[16];
+
+    int count = m_interrupt->read(events, 16);
+
+    if(count <= 0)
+        return count == 0;
+
+    m_interruptCount += count;
+    m_lastInterrupt = events[count - 1].timestamp / 1000;
+
+    if(!m_interval)
+        return true;
+
+    m_pendingInterrupts += count;
+
+    if(m_pendingInterrupts < m_interruptsPerDrain)
+        return true;
+
+    m_eventSamples = m_pendingInterrupts;
+    m_pendingInterrupts = 0;
+    m_eventTimestamp = m_lastInterrupt;
+
+    bool ok = sample();
+    m_eventTimestamp = 0;
+
+    return ok;
+}
+
+/*!
+ * Reads the samples of one cycle. Returns false with errno set on bus errors.
+ */
+bool QMPU6050Acquisition::readSamples()
+{
+    if(m_mode == FIFOMode)
+        return drain();
+
+    //INT_STATUS sits right in front of the data registers, status polling
+    //reads it in the same burst
+    quint8 buffer[15];
+    quint8 *data = m_statusPollingActive ? buffer + 1 : buffer;
+
+    if(!m_i2c->start())
+        return false;
+
+    if(!m_i2c->read(static_cast<quint8>(m_statusPollingActive ? MPU6050_RA_INT_STATUS : MPU6050_RA_ACCEL_XOUT_H), buffer, m_statusPollingActive ? 15 : 14))
+    {
+        int error = errno;
+        m_i2c->end();
+        errno = error;
+        return false;
+    }
+
+    m_i2c->end();
+
+    quint64 now = m_eventTimestamp ? m_eventTimestamp : timestamp();
+    quint32 gap = 0;
+
+    if(m_statusPollingActive)
+    {
+        if(!(buffer[0] & (1 << MPU6050_INTERRUPT_DATA_RDY_BIT)))
+        {
+            ++m_duplicateSampleCount;
+            return true;
+        }
+
+        ++m_dataReadyCount;
+
+        //DATA_RDY latches one sample, a longer gap means samples were overwritten
+        quint64 period = static_cast<quint64>(1000000 / m_rate);
+        quint32 samples = 1;
+
+        if(m_lastDataReady && now - m_lastDataReady > period * 3 / 2)
+        {
+            quint64 missed = (now - m_lastDataReady + period / 2) / period - 1;
+            m_missedSampleCount += missed;
+            samples += static_cast<quint32>(missed);
+        }
+
+        gap = samples - 1;
+
+        m_lastDataReady = now;
+
+        updateTimestamps(samples, now);
+    }
+    else if(m_eventTimestamp)
+        updateTimestamps(qMax<quint32>(1, m_eventSamples), now);
+
+    //plain polling does not know when the chip sampled, use the read time
+    m_sampleFrame.timestamp = m_statusPollingActive || m_eventTimestamp ? m_timestamper.timestamp(gap) : now;
+    m_sampleFrame.gap = gap;
+
+    const QMPU6050Decoder::Scale *scale = m_scale.loadAcquire();
+
+    m_sampleFrame.accelerationRange = QMPU6050Decoder::accelerationRange(scale);
+    m_sampleFrame.rotationRange = QMPU6050Decoder::rotationRange(scale);
+
+    if(m_floatingPoint)
+        decode(data, &m_sampleFrame, *scale);
+    else
+        decodeRaw(data, AllSources, &m_sampleFrame);
+
+    m_frameRing.publish(m_sampleFrame);
+    m_queue.push(m_sampleFrame);
+    scheduleDispatch();
+
+    return true;
+}
+
+/*!
+ * Empties the FIFO in whole packets and queues one frame per packet,
+ * timestamped by the chip's tracked sample clock. An overflowed or
+ * misaligned FIFO is handed to resynchronize() instead.
+ */
+bool QMPU6050Acquisition::drain()
+{
+    quint8 countBuffer[2];
+
+    if(!m_i2c->start())
+        return false;
+
+    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_FIFO_COUNTH), countBuffer, 2))
+    {
+        int error = errno;
+        m_i2c->end();
+        errno = error;
+        return false;
+    }
+
+    quint16 count = (static_cast<quint16>(countBuffer[0]) << 8) | countBuffer[1];
+    quint64 now = m_eventTimestamp ? m_eventTimestamp : timestamp();
+
+    //the chip only appends whole packets, a remainder that stays put means
+    //the read pointer slipped into the middle of one
+    quint16 remainder = count % m_packetSize;
+
+    if(remainder && remainder == m_fifoRemainder)
+        ++m_misalignedDrains;
+    else
+        m_misalignedDrains = 0;
+
+    m_fifoRemainder = remainder;
+
+    //a full FIFO has overwritten its oldest bytes and lost packet alignment
+    if(count >= MPU6050_FIFO_SIZE || m_misalignedDrains >= misalignmentLimit || m_resyncRequested.fetchAndStoreOrdered(0))
+    {
+        bool ok = resynchronize(count >= MPU6050_FIFO_SIZE, now);
+        int error = errno;
+        m_i2c->end();
+        errno = error;
+        return ok;
+    }
+
+    count -= remainder;
+
+    if(count == 0)
+    {
+        m_i2c->end();
+        return true;
+    }
+
+    if(!m_i2c->readStream(static_cast<quint8>(MPU6050_RA_FIFO_R_W), m_fifoBuffer, count))
+    {
+        int error = errno;
+        m_i2c->end();
+
+        //part of the stream may have been consumed
+        m_resyncRequested.storeRelaxed(1);
+
+        errno = error;
+        return false;
+    }
+
+    m_i2c->end();
+
+    quint32 lost = m_pendingGap;
+    m_pendingGap = 0;
+
+    queuePackets(m_fifoBuffer, count / m_packetSize, lost, now);
+
+    return true;
+}
+
+/*!
+ * Recovers packet alignment with as little loss as possible. FIFO writes are
+ * stopped so the FIFO ends on a packet boundary, every byte is read out and
+ * the partial packet at the front is dropped; the rest is delivered. The
+ * FIFO then restarts empty. Samples missing from the stream are estimated
+ * from the tracked sample clock and reported as a gap on the first frame
+ * after them. Runs with the device started.
+ */
+bool QMPU6050Acquisition::resynchronize(bool overflow, quint64 now)
+{
+    quint8 countBuffer[2];
+    quint8 stopped = 0;
+
+    if(!m_i2c->write(static_cast<quint8>(MPU6050_RA_FIFO_EN), &stopped, 1)
+       || !m_i2c->read(static_cast<quint8>(MPU6050_RA_FIFO_COUNTH), countBuffer, 2))
+        return false;
+
+    quint16 count = qMin<quint16>((static_cast<quint16>(countBuffer[0]) << 8) | countBuffer[1], MPU6050_FIFO_SIZE);
+
+    if(count && !m_i2c->readStream(static_cast<quint8>(MPU6050_RA_FIFO_R_W), m_fifoBuffer, count))
+        return false;
+
+    QI2CTransaction transaction(m_i2c);
+
+    if(!transaction.writeBit(static_cast<quint8>(MPU6050_RA_USER_CTRL), static_cast<quint8>(MPU6050_USERCTRL_FIFO_RESET_BIT), true)
+       || !transaction.write(static_cast<quint8>(MPU6050_RA_FIFO_EN), m_fifoSources)
+       || !transaction.submit())
+        return false;
+
+    quint64 restarted = timestamp();
+    quint16 offset = count % m_packetSize;
+    quint16 packets = count / m_packetSize;
+    qreal period = m_timestamper.period();
+
+    ++m_fifoResyncCount;
+
+    if(overflow)
+        ++m_fifoOverflowCount;
+
+    m_misalignedDrains = 0;
+    m_fifoRemainder = 0;
+
+    //whatever the chip sampled since the last read and is not in the FIFO
+    //any more is lost
+    quint32 lost = m_pendingGap;
+
+    if(m_lastRead && period > 0 && now > m_lastRead)
+    {
+        quint64 expected = qRound64((now - m_lastRead) / period);
+
+        if(expected > packets)
+            lost += static_cast<quint32>(expected - packets);
+    }
+
+    //and so is whatever it sampled while writes were stopped
+    m_pendingGap = period > 0 && restarted > now ? static_cast<quint32>(qRound64((restarted - now) / period)) : 0;
+
+    //the sample sequence broke, take the phase from the next read again
+    m_timestamper.resync();
+
+    queuePackets(m_fifoBuffer + offset, packets, lost, now);
+
+    return true;
+}
+
+/*!
+ * Decodes \a packets FIFO packets, the newest read at \a now, and queues
+ * them. The first one is marked as following \a lost missing samples.
+ */
+void QMPU6050Acquisition::queuePackets(const quint8 *buffer, quint16 packets, quint32 lost, quint64 now)
+{
+    if(packets == 0)
+    {
+        m_pendingGap = lost;
+        return;
+    }
+
+    if(lost)
+    {
+        ++m_gapCount;
+        m_lostSampleCount += lost;
+    }
+
+    updateTimestamps(lost + packets, now);
+
+    //accel + gyro packets, with or without temperature, go through the
+    //vectorized block decoder first
+    bool block = m_floatingPoint && QMPU6050Decoder::isSupported(m_packetSize);
+    const QMPU6050Decoder::Scale *scale = m_scale.loadAcquire();
+
+    m_sampleFrame.accelerationRange = QMPU6050Decoder::accelerationRange(scale);
+    m_sampleFrame.rotationRange = QMPU6050Decoder::rotationRange(scale);
+
+    if(block)
+    {
+        QMPU6050Decoder::Output output;
+
+        for(int channel = 0; channel < QMPU6050Decoder::ChannelCount; ++channel)
+        {
+            output.values[channel] = m_decodedValues[channel];
+            output.raw[channel] = m_decodedRaw[channel];
+        }
+
+        QMPU6050Decoder::decode(buffer, packets, m_packetSize, *scale, &output);
+    }
+
+    for(quint16 i = 0; i < packets; ++i)
+    {
+        m_sampleFrame.timestamp = m_timestamper.timestamp(lost + i);
+        m_sampleFrame.gap = i == 0 ? lost : 0;
+
+        if(block)
+            decoded(i, &m_sampleFrame);
+        else if(m_floatingPoint)
+            decode(buffer + i * m_packetSize, m_sources, &m_sampleFrame, *scale);
+        else
+            decodeRaw(buffer + i * m_packetSize, m_sources, &m_sampleFrame);
+
+        m_frameRing.publish(m_sampleFrame);
+        m_queue.push(m_sampleFrame);
+    }
+
+    scheduleDispatch();
+}
+
+/*!
+ * Feeds \a samples new samples read at \a now to the timestamper. An
+ * interrupt edge marks the newest sample exactly; otherwise it was taken
+ * somewhere between the previous read, or one period before, and this one,
+ * so the middle of that window is the best guess.
+ */
+void QMPU6050Acquisition::updateTimestamps(quint32 samples, quint64 now)
+{
+    qreal observed = now;
+
+    if(!m_eventTimestamp)
+    {
+        quint64 earliest = now - qMin<quint64>(now, qRound64(m_timestamper.period()));
+
+        if(m_lastRead > earliest && m_lastRead < now)
+            earliest = m_lastRead;
+
+        observed = (earliest + now) / 2.0;
+    }
+
+    m_lastRead = now;
+    m_timestamper.update(samples, observed, now);
+}
+
+/*!
+ * Starts the recovery of a sampling cycle that failed with \a error. The
+ * first retry is due after the initial backoff.
+ */
+bool QMPU6050Acquisition::fault(int error)
+{
+    ++m_faults.faults;
+
+    m_retryCount = 0;
+    m_nextBackoff = m_retryBackoff;
+
+    if(m_retryLimit == 0)
+        return escalate(ReopeningState, error, 0);
+
+    return escalate(RetryingState, error, timestamp() + m_nextBackoff);
+}
+
+/*!
+ * Runs the due stage of the recovery: a retry, a reopen or a
+ * reinitialization. A stage that fails schedules the next one instead of
+ * waiting for it here. Emits errorOccurred() if every stage failed.
+ */
+bool QMPU6050Acquisition::recover()
+{
+    int error = m_faults.lastError;
+
+    switch(faultState())
+    {
+    case FailedState:
+        //once per recovery interval the whole escalation starts over
+        ++m_faults.faults;
+
+        m_retryCount = 0;
+        m_nextBackoff = m_retryBackoff;
+
+        if(m_retryLimit == 0)
+            return escalate(ReopeningState, error, 0);
+
+        setFaultState(RetryingState, error);
+        Q_FALLTHROUGH();
+
+    case RetryingState:
+        //transient glitches and NACKs usually clear on a plain retry
+        ++m_faults.retries;
+
+        if(readSamples())
+            return recovered();
+
+        error = errno;
+
+        if(++m_retryCount < m_retryLimit)
+        {
+            m_nextBackoff = qMin(m_nextBackoff * 2, m_retryBackoffLimit);
+            return escalate(RetryingState, error, timestamp() + m_nextBackoff);
+        }
+
+        return escalate(ReopeningState, error, 0);
+
+    case ReopeningState:
+        //a fresh fd clears adapter state and shows whether the chip kept its setup
+        ++m_faults.reopens;
+
+        if(reopen() && readSamples())
+            return recovered();
+
+        return escalate(ReinitializingState, errno, 0);
+
+    case ReinitializingState:
+        ++m_faults.reinitializations;
+
+        if(reinitialize() && readSamples())
+            return recovered();
+
+        error = errno;
+        ++m_faults.failures;
+
+        escalate(FailedState, error, timestamp() + recoveryInterval);
+        emit errorOccurred(error);
+
+        return false;
+
+    case HealthyState:
+        break;
+    }
+
+    return true;
+}
+
+/*!
+ * Moves the recovery to \a state, due at \a deadline. Always returns false,
+ * the cycle did not deliver samples.
+ */
+bool QMPU6050Acquisition::escalate(FaultState state, int error, quint64 deadline)
+{
+    m_faults.lastError = error;
+    m_nextRecovery = deadline;
+
+    setFaultState(state, error);
+
+    return false;
+}
+
+bool QMPU6050Acquisition::recovered()
+{
+    ++m_faults.recoveries;
+    setFaultState(HealthyState, 0);
+
+    return true;
+}
+
+/*!
+ * Checks that the chip answers with its identity and still runs with the
+ * power configuration we gave it. A chip that browned out comes back asleep
+ * with PWR_MGMT_1 at its reset value, which fails with ESTALE.
+ */
+bool QMPU6050Acquisition::verify()
+{
+    quint8 identity = 0;
+    quint8 power = 0;
+    quint8 expected = 0;
+
+    if(!m_i2c->start())
+        return false;
+
+    QMutexLocker locker(m_i2c->handle() ? m_i2c->handle()->mutex() : nullptr);
+
+    //reading PWR_MGMT_1 refreshes its shadow, keep the configured value
+    bool configured = m_i2c->shadow()->peek(static_cast<quint8>(MPU6050_RA_PWR_MGMT_1), &expected);
+
+    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_WHO_AM_I), &identity, 1)
+        || !m_i2c->read(static_cast<quint8>(MPU6050_RA_PWR_MGMT_1), &power, 1))
+    {
+        int error = errno;
+        m_i2c->end();
+        errno = error;
+        return false;
+    }
+
+    m_i2c->end();
+
+    if(((identity >> 1) & 0x3F) != ((MPU6050_ADDRESS_AD0_LOW >> 1) & 0x3F))
+    {
+        errno = ENODEV;
+        return false;
+    }
+
+    if(configured && power != expected)
+    {
+        //leave the configured value for reinitialize()
+        m_i2c->shadow()->store(static_cast<quint8>(MPU6050_RA_PWR_MGMT_1), expected);
+
+        errno = ESTALE;
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+ * Drops the bus fd and opens it again, then verifies the chip.
+ */
+bool QMPU6050Acquisition::reopen()
+{
+    m_i2c->close();
+
+    if(!m_i2c->start())
+        return false;
+
+    m_i2c->end();
+
+    return verify();
+}
+
+//configuration registers reinitialize() writes back, PWR_MGMT_1 and
+//USER_CTRL are handled separately to order the wake up and the FIFO restart
+static const quint8 restoredRegisters[] =
+{
+    MPU6050_RA_XG_OFFS_TC, MPU6050_RA_YG_OFFS_TC, MPU6050_RA_ZG_OFFS_TC,
+    MPU6050_RA_X_FINE_GAIN, MPU6050_RA_Y_FINE_GAIN, MPU6050_RA_Z_FINE_GAIN,
+    MPU6050_RA_XA_OFFS_H, MPU6050_RA_XA_OFFS_L_TC,
+    MPU6050_RA_YA_OFFS_H, MPU6050_RA_YA_OFFS_L_TC,
+    MPU6050_RA_ZA_OFFS_H, MPU6050_RA_ZA_OFFS_L_TC,
+    MPU6050_RA_XG_OFFS_USRH, MPU6050_RA_XG_OFFS_USRL,
+    MPU6050_RA_YG_OFFS_USRH, MPU6050_RA_YG_OFFS_USRL,
+    MPU6050_RA_ZG_OFFS_USRH, MPU6050_RA_ZG_OFFS_USRL,
+    MPU6050_RA_SMPLRT_DIV, MPU6050_RA_CONFIG,
+    MPU6050_RA_GYRO_CONFIG, MPU6050_RA_ACCEL_CONFIG,
+    MPU6050_RA_FF_THR, MPU6050_RA_FF_DUR,
+    MPU6050_RA_MOT_THR, MPU6050_RA_MOT_DUR,
+    MPU6050_RA_ZRMOT_THR, MPU6050_RA_ZRMOT_DUR,
+    MPU6050_RA_FIFO_EN, MPU6050_RA_INT_PIN_CFG, MPU6050_RA_INT_ENABLE,
+    MPU6050_RA_MOT_DETECT_CTRL, MPU6050_RA_PWR_MGMT_2
+};
+
+/*!
+ * Writes the last known configuration held in the register shadow back to
+ * the chip, restarts the FIFO if it was streaming and arms DATA_RDY again if
+ * the engine relies on it. This covers chips that lost power or were reset,
+ * after a reset the shadow is empty and only the engine's own sampling setup
+ * comes back; DMP firmware is not restored. Only the configuration registers
+ * in restoredRegisters are replayed, read-only and trigger registers such as
+ * WHO_AM_I or SIGNAL_PATH_RESET are left alone.
+ */
+bool QMPU6050Acquisition::reinitialize()
+{
+    if(!m_i2c->start())
+        return false;
+
+    quint8 registers[sizeof(restoredRegisters)];
+    quint8 values[sizeof(restoredRegisters)];
+    int count = 0;
+
+    quint8 power = (MPU6050_CLOCK_PLL_XGYRO << (MPU6050_PWR1_CLKSEL_BIT - MPU6050_PWR1_CLKSEL_LENGTH + 1));
+    quint8 userControl = 0;
+
+    {
+        QMutexLocker locker(m_i2c->handle() ? m_i2c->handle()->mutex() : nullptr);
+        QI2CRegisterShadow *shadow = m_i2c->shadow();
+
+        shadow->peek(static_cast<quint8>(MPU6050_RA_PWR_MGMT_1), &power);
+        shadow->peek(static_cast<quint8>(MPU6050_RA_USER_CTRL), &userControl);
+
+        for(quint8 registerAddress : restoredRegisters)
+        {
+            if(shadow->peek(registerAddress, &values[count]))
+                registers[count++] = registerAddress;
+        }
+    }
+
+    //wake the chip first, the FIFO is restarted by enableFIFO() afterwards
+    QI2CTransaction transaction(m_i2c);
+
+    bool ok = transaction.write(static_cast<quint8>(MPU6050_RA_PWR_MGMT_1), power);
+
+    for(int i = 0; ok && i < count; ++i)
+    {
+        if(transaction.messageCount() + 2 > QI2CTransaction::maxMessages)
+            ok = transaction.submit();
+
+        ok = ok && transaction.write(registers[i], values[i]);
+    }
+
+    ok = ok && transaction.write(static_cast<quint8>(MPU6050_RA_USER_CTRL), static_cast<quint8>(userControl & ~(1 << MPU6050_USERCTRL_FIFO_EN_BIT)))
+            && transaction.submit();
+
+    int error = errno;
+    m_i2c->end();
+
+    if(!ok)
+    {
+        errno = error;
+        return false;
+    }
+
+    updateScale();
+
+    if(m_fifoActive)
+    {
+        m_fifoActive = false;
+
+        if(!enableFIFO())
+            return false;
+    }
+
+    //after a chip reset the shadow held nothing to restore, arm DATA_RDY again
+    if(m_interruptActive || m_statusPollingActive)
+        return enableDataReady(m_interruptActive);
+
+    return true;
+}
+
+void QMPU6050Acquisition::setFaultState(FaultState state, int error)
+{
+    if(m_faultState.fetchAndStoreOrdered(state) != state)
+        emit faultStateChanged(state, error);
+}
+
+QMPU6050Acquisition::FaultState QMPU6050Acquisition::faultState() const
+{
+    return static_cast<FaultState>(m_faultState.loadRelaxed());
+}
+
+QMPU6050Acquisition::FaultStatistics QMPU6050Acquisition::faultStatistics() const
+{
+    QMutexLocker locker(m_thread ? m_thread->mutex() : nullptr);
+    return m_faults;
+}
+
+/*!
+ * Sets how often a failed sampling cycle is retried before the bus is
+ * reopened, and the backoff in microseconds before the first retry, which
+ * doubles up to \a backoffLimit.
+ */
+void QMPU6050Acquisition::setRetryPolicy(int retries, quint64 backoff, quint64 backoffLimit)
+{
+    QMutexLocker locker(m_thread ? m_thread->mutex() : nullptr);
+
+    m_retryLimit = qMax(0, retries);
+    m_retryBackoff = qMax<quint64>(1, backoff);
+    m_retryBackoffLimit = qMax(m_retryBackoff, backoffLimit);
+}
+
+/*!
+ * Asks the sampling thread to recover the chip before its next cycle.
+ * Backends call this when their own register accesses fail, \a error is the
+ * errno of the failed access and picks where recovery starts: EBADF and
+ * ENODEV reopen the bus, ESTALE (the chip was reset or lost power) waits for
+ * the chip to come back and restores its configuration, anything else
+ * verifies the chip first and escalates only if that fails.
+ */
+void QMPU6050Acquisition::requestRecovery(int error)
+{
+    m_recoveryRequested.storeRelease(error ? error : EIO);
+}
+
+/*!
+ * Wakes the consumer thread once for any number of queued frames.
+ */
+void QMPU6050Acquisition::scheduleDispatch()
+{
+    if(!m_thread)
+        return;
+
+    if(m_dispatchPending.fetchAndStoreOrdered(1) == 0)
+        QMetaObject::invokeMethod(this, "dispatch", Qt::QueuedConnection);
+}
+
+/*!
+ * Delivers every queued frame on the consumer thread, followed by one batch
+ * holding all of them.
+ */
+void QMPU6050Acquisition::dispatch()
+{
+    m_dispatchPending.storeRelease(0);
+
+    if(m_queue.isEmpty())
+        return;
+
+    if(m_floatingPoint)
+    {
+        m_batch = nextBatch();
+        m_batch->clear();
+        m_batch->reserve(m_queue.count());
+    }
+
+    while(m_queue.pop(&m_frame))
+    {
+        //reported in stream order so consumers can reset their filters
+        if(m_frame.gap)
+            emit gapDetected(m_frame.timestamp, m_frame.gap);
+
+        deliver();
+
+        if(m_floatingPoint)
+            m_batch->append(m_frame);
+    }
+
+    if(m_floatingPoint)
+        deliverBatch();
+}
+
+void QMPU6050Acquisition::deliver()
+{
+    //collect the due listeners first, they may detach while handling the frame
+    QVarLengthArray<QMPU6050FrameListener*, 8> due;
+    QVarLengthArray<QMPU6050FrameListener*, 8> dueFixed;
+
+    for(Listener &entry : m_listeners)
+    {
+        if(++entry.counter < entry.divider)
+            continue;
+
+        entry.counter = 0;
+
+        if(entry.format == FixedPointOutput)
+            dueFixed.append(entry.listener);
+        else
+            due.append(entry.listener);
+    }
+
+    for(QMPU6050FrameListener *listener : due)
+    {
+        if(isAttached(listener))
+            listener->frameReceived(m_frame);
+    }
+
+    if(m_floatingPoint)
+        emit frameReady(m_frame);
+
+    //like frameReady(), fixedFrameReady() carries every sample, but only
+    //while some listener asked for fixed point
+    if(!m_fixedPoint)
+        return;
+
+    QMPU6050FixedFrame fixed = fixedFrame(m_frame);
+
+    for(QMPU6050FrameListener *listener : dueFixed)
+    {
+        if(isAttached(listener))
+            listener->fixedFrameReceived(fixed);
+    }
+
+    emit fixedFrameReady(fixed);
+}
+
+/*!
+ * Hands the samples of the current wakeup to every listener in one block.
+ * Batches are not decimated, they carry every sample at the engine rate.
+ */
+void QMPU6050Acquisition::deliverBatch()
+{
+    QVarLengthArray<QMPU6050FrameListener*, 8> listeners;
+
+    for(const Listener &entry : m_listeners)
+        listeners.append(entry.listener);
+
+    for(QMPU6050FrameListener *listener : listeners)
+    {
+        if(isAttached(listener))
+            listener->batchReceived(*m_batch);
+    }
+
+    emit batchReady(*m_batch);
+}
+
+/*!
+ * Returns the pooled batch to fill next: the current one if nobody kept a
+ * copy of it, otherwise the first one that was released. Its arrays keep
+ * their capacity, so a steady batch size needs no allocation. Only when
+ * receivers hold every pooled batch does the next one detach.
+ */
+QMPU6050Batch *QMPU6050Acquisition::nextBatch()
+{
+    qsizetype current = m_batch - m_batches;
+
+    for(int i = 0; i < batchPoolSize; ++i)
+    {
+        QMPU6050Batch *batch = &m_batches[(current + i) % batchPoolSize];
+
+        if(batch->isDetached())
+            return batch;
+    }
+
+    return &m_batches[(current + 1) % batchPoolSize];
+}
+
+void QMPU6050Acquisition::updateInterval()
+{
+    //keep the acquisition thread out while the sampling state changes
+    QMutexLocker locker(m_thread ? m_thread->mutex() : nullptr);
+
+    qreal rate = 0;
+    Mode mode = PollingMode;
+    Sources sources = NoSource;
+    bool floatingPoint = m_listeners.isEmpty();
+    bool fixedPoint = false;
+
+    for(const Listener &entry : m_listeners)
+    {
+        rate = qMax(rate, entry.rate);
+        sources |= entry.sources;
+
+        if(entry.format == FloatingPointOutput)
+            floatingPoint = true;
+        else
+            fixedPoint = true;
+
+        if(entry.mode == FIFOMode)
+            mode = FIFOMode;
+    }
+
+    if(m_listeners.isEmpty())
+    {
+        m_pollTimer->stop();
+
+        if(m_fifoActive)
+            disableFIFO();
+
+        if(m_interruptActive)
+            disableInterrupt();
+
+        if(m_statusPollingActive)
+        {
+            m_statusPollingActive = false;
+            disableDataReady();
+        }
+
+        m_rate = 0;
+        m_interval = 0;
+        return;
+    }
+
+    m_mode = mode;
+    m_sources = sources ? sources : Sources(AllSources);
+
+    //do not leave stale scaled values behind once nobody converts them
+    if(m_floatingPoint && !floatingPoint)
+    {
+        for(int i = 0; i < 3; ++i)
+        {
+            m_sampleFrame.acceleration[i] = 0;
+            m_sampleFrame.rotation[i] = 0;
+        }
+
+        m_sampleFrame.temperature = 0;
+    }
+
+    m_floatingPoint = floatingPoint;
+    m_fixedPoint = fixedPoint;
+
+    if(!updateScale())
+        qDebug() << QString("COULD NOT READ FULL SCALE RANGES ON %1").arg(m_bus);
+
+    //the acquisition thread is not bound to the millisecond timer
+    if(m_mode == PollingMode && m_thread)
+        m_rate = qMin(rate, gyroscopeRate);
+    else
+        m_rate = qMin(rate, maximumRate(mode, sources));
+
+    if(m_mode == FIFOMode)
+    {
+        if(!enableFIFO())
+        {
+            emit errorOccurred(errno);
+            m_pollTimer->stop();
+            m_interval = 0;
+            return;
+        }
+    }
+    else if(m_fifoActive)
+        disableFIFO();
+
+    //slower listeners receive every n-th frame
+    for(Listener &entry : m_listeners)
+    {
+        entry.divider = qMax<quint32>(1, static_cast<quint32>(qRound(m_rate / entry.rate)));
+        entry.counter = 0;
+    }
+
+    //the chip paces an interrupt driven engine, enableInterrupt() programs
+    //the sample rate for PollingMode
+    if(m_interrupt && !enableInterrupt())
+    {
+        qDebug() << QString("COULD NOT ENABLE DATA READY INTERRUPT ON %1, FALLING BACK TO THE TIMER").arg(m_bus);
+        disableInterrupt();
+    }
+
+    //without an interrupt line the DATA_RDY status tells new frames apart
+    bool statusPolling = m_statusPolling && m_mode == PollingMode && !m_interruptActive;
+
+    if(statusPolling && !enableDataReady(false))
+    {
+        qDebug() << QString("COULD NOT ENABLE DATA READY STATUS ON %1, POLLING WITHOUT IT").arg(m_bus);
+        statusPolling = false;
+    }
+
+    if(m_statusPollingActive && !statusPolling && !m_interruptActive)
+        disableDataReady();
+
+    m_statusPollingActive = statusPolling;
+    m_lastDataReady = 0;
+
+    //m_rate now is what the chip was programmed for
+    m_timestamper.setNominalPeriod(1000000 / m_rate);
+    m_lastRead = 0;
+
+    if(m_mode == FIFOMode)
+    {
+        //drain well before the FIFO can fill up
+        qreal fill = (MPU6050_FIFO_SIZE / m_packetSize) * 1000000 / m_rate;
+        m_interval = qBound<quint64>(1000, qRound64(fill / 4), drainIntervalLimit * 1000);
+    }
+    else
+        m_interval = qMax<quint64>(1, qRound64(1000000 / m_rate));
+
+    if(m_interruptActive)
+    {
+        //drain after one interval worth of samples, time out after a few
+        //missing edges
+        m_interruptsPerDrain = m_mode == FIFOMode ? qMax<quint32>(1, static_cast<quint32>(m_interval * m_rate / 1000000)) : 1;
+        m_pendingInterrupts = 0;
+        m_interval *= m_mode == FIFOMode ? 2 : 4;
+    }
+
+    //poll at twice the sample rate so no sample is missed to jitter
+    if(m_statusPollingActive)
+        m_interval = qMax<quint64>(1, m_interval / 2);
+
+    if(m_interruptNotifier)
+        m_interruptNotifier->setEnabled(m_interruptActive && !m_thread);
+
+    if(m_thread)
+    {
+        m_thread->reschedule(this);
+        return;
+    }
+
+    m_pollTimer->setInterval(qMax(1, static_cast<int>(m_interval / 1000)));
+
+    if(!m_pollTimer->isActive())
+        m_pollTimer->start();
+}
+
+/*!
+ * Moves sampling between the consumer thread's poll timer and the shared
+ * acquisition thread of the bus. Frames are always delivered on the thread
+ * this engine lives in.
+ */
+void QMPU6050Acquisition::setThreaded(bool threaded)
+{
+    if(threaded == isThreaded())
+        return;
+
+    if(threaded)
+    {
+        m_pollTimer->stop();
+
+        m_thread = QMPU6050AcquisitionThread::acquire(m_bus);
+        m_thread->add(this);
+    }
+    else
+    {
+        m_thread->remove(this);
+        QMPU6050AcquisitionThread::release(m_thread);
+        m_thread = nullptr;
+
+        //hand over whatever the thread produced last
+        dispatch();
+    }
+
+    updateInterval();
+}
+
+bool QMPU6050Acquisition::isThreaded() const
+{
+    return m_thread != nullptr;
+}
+
+QMPU6050AcquisitionThread *QMPU6050Acquisition::acquisitionThread() const
+{
+    return m_thread;
+}
+
+/*!
+ * Applies the acquisition settings given as dynamic properties on \a sensor:
+ * "acquisition-thread" (bool), "acquisition-policy" ("other", "fifo" or "rr"),
+ * "acquisition-priority" (int), "acquisition-cpu" (int), "interrupt-gpio"
+ * ("<gpiochip>:<line>" the INT pin is wired to), "interrupt-active-low"
+ * (bool) and "status-polling" (bool).
+ */
+void QMPU6050Acquisition::configure(const QObject *sensor)
+{
+    if(!sensor)
+        return;
+
+    if(sensor->property("acquisition-thread").isValid())
+        setThreaded(sensor->property("acquisition-thread").toBool());
+
+    if(sensor->property("status-polling").isValid())
+        setStatusPolling(sensor->property("status-polling").toBool());
+
+    if(sensor->property("interrupt-gpio").isValid())
+    {
+        QString line = sensor->property("interrupt-gpio").toString();
+        setInterruptSource(line.isEmpty() ? nullptr : QGPIOInterruptSource::fromString(line, sensor->property("interrupt-active-low").toBool()));
+    }
+
+    if(!m_thread)
+        return;
+
+    if(sensor->property("acquisition-policy").isValid())
+    {
+        QString policy = sensor->property("acquisition-policy").toString().toLower();
+
+        if(policy == "fifo")
+            m_thread->setSchedulingPolicy(QMPU6050AcquisitionThread::FIFOPolicy);
+        else if(policy == "rr")
+            m_thread->setSchedulingPolicy(QMPU6050AcquisitionThread::RoundRobinPolicy);
+        else
+            m_thread->setSchedulingPolicy(QMPU6050AcquisitionThread::OtherPolicy);
+    }
+
+    if(sensor->property("acquisition-priority").isValid())
+        m_thread->setSchedulingPriority(sensor->property("acquisition-priority").toInt());
+
+    if(sensor->property("acquisition-cpu").isValid())
+        m_thread->setCpuAffinity(sensor->property("acquisition-cpu").toInt());
+}
+
+quint64 QMPU6050Acquisition::interval() const
+{
+    return m_interval;
+}
+
+/*!
+ * Programs SMPLRT_DIV and the DLPF for the current rate, routes the current
+ * sources into the FIFO and starts it from empty. Updates m_rate to the rate
+ * the chip actually runs at.
+ */
+bool QMPU6050Acquisition::enableFIFO()
+{
+    quint8 divider = 0;
+    quint8 dlpfMode = MPU6050_DLPF_BW_5;
+    qreal rate = sampleRateSettings(m_rate, &divider, &dlpfMode);
+
+    quint8 fifoSources = 0;
+
+    if(m_sources & Accelerometer)
+        fifoSources |= (1 << MPU6050_ACCEL_FIFO_EN_BIT);
+    if(m_sources & Temperature)
+        fifoSources |= (1 << MPU6050_TEMP_FIFO_EN_BIT);
+    if(m_sources & Gyroscope)
+        fifoSources |= (1 << MPU6050_XG_FIFO_EN_BIT) | (1 << MPU6050_YG_FIFO_EN_BIT) | (1 << MPU6050_ZG_FIFO_EN_BIT);
+
+    m_rate = rate;
+    m_packetSize = packetSize(m_sources);
+
+    //nothing to reprogram if the chip already streams this configuration
+    if(m_fifoActive && m_sampleRateDivider == divider && m_dlpfMode == dlpfMode && m_fifoSources == fifoSources)
+        return true;
+
+    if(!m_i2c->start())
+        return false;
+
+    QI2CTransaction transaction(m_i2c);
+
+    bool ok = transaction.writeBit(static_cast<quint8>(MPU6050_RA_USER_CTRL), static_cast<quint8>(MPU6050_USERCTRL_FIFO_EN_BIT), false)
+              && transaction.write(static_cast<quint8>(MPU6050_RA_FIFO_EN), 0)
+              && transaction.write(static_cast<quint8>(MPU6050_RA_SMPLRT_DIV), divider)
+              && transaction.writeBits(static_cast<quint8>(MPU6050_RA_CONFIG), dlpfMode, static_cast<quint8>(MPU6050_CFG_DLPF_CFG_BIT), static_cast<quint8>(MPU6050_CFG_DLPF_CFG_LENGTH))
+              && transaction.write(static_cast<quint8>(MPU6050_RA_FIFO_EN), fifoSources)
+              && transaction.writeBit(static_cast<quint8>(MPU6050_RA_USER_CTRL), static_cast<quint8>(MPU6050_USERCTRL_FIFO_RESET_BIT), true)
+              && transaction.writeBit(static_cast<quint8>(MPU6050_RA_USER_CTRL), static_cast<quint8>(MPU6050_USERCTRL_FIFO_EN_BIT), true)
+              && transaction.submit();
+
+    m_i2c->end();
+
+    if(!ok)
+    {
+        m_fifoActive = false;
+        return false;
+    }
+
+    m_sampleRateDivider = divider;
+    m_dlpfMode = dlpfMode;
+    m_fifoSources = fifoSources;
+    m_fifoActive = true;
+
+    m_fifoRemainder = 0;
+    m_misalignedDrains = 0;
+    m_pendingGap = 0;
+    m_resyncRequested.storeRelaxed(0);
+
+    //the FIFO restarted empty, samples no longer follow the tracked phase
+    m_timestamper.resync();
+    m_lastRead = 0;
+
+    return true;
+}
+
+bool QMPU6050Acquisition::disableFIFO()
+{
+    m_fifoActive = false;
+
+    if(!m_i2c->start())
+        return false;
+
+    QI2CTransaction transaction(m_i2c);
+
+    bool ok = transaction.writeBit(static_cast<quint8>(MPU6050_RA_USER_CTRL), static_cast<quint8>(MPU6050_USERCTRL_FIFO_EN_BIT), false)
+              && transaction.write(static_cast<quint8>(MPU6050_RA_FIFO_EN), 0)
+              && transaction.submit();
+
+    m_i2c->end();
+
+    return ok;
+}
+
+/*!
+ * Works out SMPLRT_DIV and the DLPF mode for \a rate and returns the rate
+ * the chip will actually run at.
+ */
+qreal QMPU6050Acquisition::sampleRateSettings(qreal rate, quint8 *divider, quint8 *dlpfMode)
+{
+    qreal outputRate = gyroscopeRate;
+    *dlpfMode = MPU6050_DLPF_BW_5;
+
+    if(rate > gyroscopeRate)
+    {
+        //8 kHz gyro output needs the DLPF off
+        outputRate = gyroscopeRateUnfiltered;
+        *dlpfMode = MPU6050_DLPF_BW_256;
+    }
+    else
+    {
+        //widest bandwidth that still respects nyquist for the sample rate
+        for(quint8 i = 0; i < sizeof(dlpfBandwidth) / sizeof(dlpfBandwidth[0]); ++i)
+        {
+            if(dlpfBandwidth[i] <= rate / 2)
+            {
+                *dlpfMode = MPU6050_DLPF_BW_188 + i;
+                break;
+            }
+        }
+    }
+
+    *divider = static_cast<quint8>(qBound(0, qRound(outputRate / rate) - 1, 255));
+
+    return outputRate / (1 + *divider);
+}
+
+/*!
+ * Works out SMPLRT_DIV for \a rate with the DLPF left at \a dlpfMode and
+ * returns the rate the chip will actually run at. The gyroscope outputs at
+ * 8 kHz only with the DLPF off, i.e. DLPF_CFG 0 or the reserved 7.
+ */
+qreal QMPU6050Acquisition::sampleRateDivider(qreal rate, quint8 dlpfMode, quint8 *divider)
+{
+    qreal outputRate = dlpfMode == MPU6050_DLPF_BW_256 || dlpfMode == 7 ? gyroscopeRateUnfiltered : gyroscopeRate;
+
+    *divider = static_cast<quint8>(qBound(0, qRound(outputRate / rate) - 1, 255));
+
+    return outputRate / (1 + *divider);
+}
+
+/*!
+ * Routes DATA_RDY to the INT pin and starts waiting for its edges.
+ */
+bool QMPU6050Acquisition::enableInterrupt()
+{
+    if(!m_interrupt->isOpen() && !m_interrupt->open())
+        return false;
+
+    m_interruptActive = enableDataReady(true);
+
+    return m_interruptActive;
+}
+
+bool QMPU6050Acquisition::disableInterrupt()
+{
+    m_interruptActive = false;
+
+    if(m_interruptNotifier)
+        m_interruptNotifier->setEnabled(false);
+
+    return disableDataReady();
+}
+
+/*!
+ * Enables DATA_RDY, signalled on the INT pin as an active high push-pull
+ * pulse. With \a anyReadClears the status clears on any register read,
+ * otherwise only reading INT_STATUS clears it. In PollingMode SMPLRT_DIV is
+ * programmed here for the current rate under the DLPF mode the user
+ * configured, in FIFOMode enableFIFO() already programmed both.
+ */
+bool QMPU6050Acquisition::enableDataReady(bool anyReadClears)
+{
+    if(!m_i2c->start())
+        return false;
+
+    QI2CTransaction transaction(m_i2c);
+    bool ok = true;
+
+    if(m_mode == PollingMode)
+    {
+        //the DLPF belongs to the user, pace DATA_RDY with SMPLRT_DIV only
+        quint8 dlpfMode = 0;
+
+        if(!m_i2c->readBits(static_cast<quint8>(MPU6050_RA_CONFIG), &dlpfMode, static_cast<quint8>(MPU6050_CFG_DLPF_CFG_BIT), static_cast<quint8>(MPU6050_CFG_DLPF_CFG_LENGTH)))
+        {
+            int error = errno;
+            m_i2c->end();
+            errno = error;
+            return false;
+        }
+
+        quint8 divider = 0;
+        m_rate = sampleRateDivider(m_rate, dlpfMode, &divider);
+
+        ok = transaction.write(static_cast<quint8>(MPU6050_RA_SMPLRT_DIV), divider);
+    }
+
+    ok = ok && transaction.writeBit(static_cast<quint8>(MPU6050_RA_INT_PIN_CFG), static_cast<quint8>(MPU6050_INTCFG_INT_LEVEL_BIT), false)
+            && transaction.writeBit(static_cast<quint8>(MPU6050_RA_INT_PIN_CFG), static_cast<quint8>(MPU6050_INTCFG_INT_OPEN_BIT), false)
+            && transaction.writeBit(static_cast<quint8>(MPU6050_RA_INT_PIN_CFG), static_cast<quint8>(MPU6050_INTCFG_LATCH_INT_EN_BIT), false)
+            && transaction.writeBit(static_cast<quint8>(MPU6050_RA_INT_PIN_CFG), static_cast<quint8>(MPU6050_INTCFG_INT_RD_CLEAR_BIT), anyReadClears)
+            && transaction.writeBit(static_cast<quint8>(MPU6050_RA_INT_ENABLE), static_cast<quint8>(MPU6050_INTERRUPT_DATA_RDY_BIT), true)
+            && transaction.submit();
+
+    m_i2c->end();
+
+    return ok;
+}
+
+bool QMPU6050Acquisition::disableDataReady()
+{
+    if(!m_i2c->start())
+        return false;
+
+    bool ok = m_i2c->writeBit(static_cast<quint8>(MPU6050_RA_INT_ENABLE), static_cast<quint8>(MPU6050_INTERRUPT_DATA_RDY_BIT), false);
+
+    m_i2c->end();
+
+    return ok;
+}
+
+/*!
+ * Makes the engine sample on the edges of \a source instead of its timer,
+ * taking ownership of it. Passing nullptr returns to timer driven sampling.
+ * Any QInterruptSource works; QGPIOInterruptSource watches the INT pin and
+ * QEventFdInterruptSource lets software raise the edges.
+ */
+void QMPU6050Acquisition::setInterruptSource(QInterruptSource *source)
+{
+    {
+        QMutexLocker locker(m_thread ? m_thread->mutex() : nullptr);
+
+        if(m_interruptActive)
+            disableInterrupt();
+
+        delete m_interruptNotifier;
+        m_interruptNotifier = nullptr;
+
+        if(m_interrupt != source)
+            delete m_interrupt;
+
+        m_interrupt = source;
+
+        if(m_interrupt && !m_interrupt->open())
+        {
+            qDebug() << QString("COULD NOT OPEN INTERRUPT SOURCE FOR %1: %2").arg(m_bus, strerror(errno));
+
+            delete m_interrupt;
+            m_interrupt = nullptr;
+        }
+
+        if(m_interrupt)
+        {
+            m_interruptNotifier = new QSocketNotifier(m_interrupt->handle(), QSocketNotifier::Read, this);
+            m_interruptNotifier->setEnabled(false);
+            QObject::connect(m_interruptNotifier, &QSocketNotifier::activated, this, &QMPU6050Acquisition::interrupted);
+        }
+    }
+
+    if(!m_listeners.isEmpty())
+        updateInterval();
+}
+
+QInterruptSource *QMPU6050Acquisition::interruptSource() const
+{
+    return m_interrupt;
+}
+
+/*!
+ * Returns true while DATA_RDY edges pace sampling.
+ */
+bool QMPU6050Acquisition::isInterruptDriven() const
+{
+    return m_interruptActive;
+}
+
+quint64 QMPU6050Acquisition::interruptCount() const
+{
+    return m_interruptCount;
+}
+
+/*!
+ * Number of times the watchdog had to sample because no edge arrived.
+ */
+quint64 QMPU6050Acquisition::interruptTimeoutCount() const
+{
+    return m_interruptTimeoutCount;
+}
+
+/*!
+ * Makes PollingMode read INT_STATUS together with the data registers in one
+ * 15 byte burst and only deliver frames flagged by DATA_RDY. The chip is
+ * programmed for the requested rate and polled at twice that rate, so it
+ * samples on the chip's clock without an interrupt line. An interrupt
+ * source takes precedence.
+ */
+void QMPU6050Acquisition::setStatusPolling(bool enabled)
+{
+    if(m_statusPolling == enabled)
+        return;
+
+    m_statusPolling = enabled;
+
+    if(!m_listeners.isEmpty())
+        updateInterval();
+}
+
+bool QMPU6050Acquisition::isStatusPolling() const
+{
+    return m_statusPolling;
+}
+
+/*!
+ * Number of status polls that found a new sample.
+ */
+quint64 QMPU6050Acquisition::dataReadyCount() const
+{
+    return m_dataReadyCount;
+}
+
+/*!
+ * Number of status polls that found no new sample. Around one per sample
+ * means the poll cadence matches SMPLRT_DIV, many more waste bus time.
+ */
+quint64 QMPU6050Acquisition::duplicateSampleCount() const
+{
+    return m_duplicateSampleCount;
+}
+
+/*!
+ * Estimated number of samples the chip produced between two status polls
+ * that were never read, from the gaps between new samples.
+ */
+quint64 QMPU6050Acquisition::missedSampleCount() const
+{
+    return m_missedSampleCount;
+}
+
+/*!
+ * Returns a copy of the sample clock tracking: the estimated period, the
+ * oscillator drift against CLOCK_MONOTONIC and the read time jitter.
+ */
+QMPU6050Timestamper QMPU6050Acquisition::timestamper() const
+{
+    QMutexLocker locker(m_thread ? m_thread->mutex() : nullptr);
+    return m_timestamper;
+}
+
+/*!
+ * Makes the next FIFO drain resynchronize, for when something else noticed
+ * FIFO_OFLOW or consumed FIFO data. Safe to call from any thread.
+ */
+void QMPU6050Acquisition::requestResync()
+{
+    m_resyncRequested.storeRelease(1);
+}
+
+/*!
+ * Number of times the FIFO was found full and had overwritten samples.
+ */
+quint64 QMPU6050Acquisition::fifoOverflowCount() const
+{
+    return m_fifoOverflowCount;
+}
+
+/*!
+ * Number of FIFO resynchronizations after overflows, misalignment or
+ * requests.
+ */
+quint64 QMPU6050Acquisition::fifoResyncCount() const
+{
+    return m_fifoResyncCount;
+}
+
+/*!
+ * Number of gaps in the FIFO stream and the samples lost in them.
+ */
+quint64 QMPU6050Acquisition::gapCount() const
+{
+    return m_gapCount;
+}
+
+quint64 QMPU6050Acquisition::lostSampleCount() const
+{
+    return m_lostSampleCount;
+}
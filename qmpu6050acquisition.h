@@ -0,0 +1,372 @@
+#ifndef QMPU6_5_ACQUISITION_H
+#define QMPU6_5_ACQUISITION_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QSocketNotifier>
+
+#include "qmpu6050_global.h"
+#include "qmpu6050_p.h"
+#include "qmpu6050frame.h"
+#include "qmpu6050batch.h"
+#include "qi2cdevice.h"
+#include "qi2ctransaction.h"
+#include "qspscqueue.h"
+#include "qmpu6050acquisitionthread.h"
+#include "qinterruptsource.h"
+#include "qmpu6050timestamper.h"
+#include "qmpu6050decoder.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Receiver interface for frames produced by QMPU6050Acquisition
+ */
+class QMPU6_5__EXPORT QMPU6050FrameListener
+{
+public:
+    virtual ~QMPU6050FrameListener() = default;
+    virtual void frameReceived(const QMPU6050Frame &frame) = 0;
+
+    //called once per poll or FIFO drain with every sample of that wakeup
+    virtual void batchReceived(const QMPU6050Batch &batch) { Q_UNUSED(batch) }
+
+    //called instead of frameReceived() for QMPU6050Acquisition::FixedPointOutput
+    virtual void fixedFrameReceived(const QMPU6050FixedFrame &frame) { Q_UNUSED(frame) }
+};
+
+/*!
+ * \brief Acquisition engine shared by every backend attached to one chip
+ *
+ * There is one engine per bus/address pair. It performs a single 14 byte
+ * burst read of the data registers per sample period and hands the decoded
+ * frame to every attached listener, so the accelerometer, gyroscope and
+ * temperature readings always come from the same sampling instant.
+ *
+ * The engine samples at the highest rate requested by its listeners;
+ * listeners asking for a lower rate receive every n-th frame.
+ *
+ * In PollingMode the data registers are read once per timer tick, which
+ * limits the rate to what a millisecond timer can sustain. In FIFOMode the
+ * chip paces itself: SMPLRT_DIV and the DLPF are programmed for the requested
+ * rate, the enabled sources are routed into the FIFO and the FIFO is drained
+ * in bursts, so every sample the chip produces is delivered. Gyroscope-only
+ * streaming runs the gyro at 8 kHz with the DLPF disabled.
+ *
+ * Sampling runs on a poll timer of the thread the engine lives in, or, when
+ * threaded, on the real-time QMPU6050AcquisitionThread of the bus. Either
+ * way frames pass through a lock-free queue and are delivered to listeners
+ * on the engine's own thread.
+ *
+ * With an interrupt source the chip's own sample clock paces acquisition:
+ * DATA_RDY is routed to the INT pin and a frame is read, or the FIFO
+ * drained after enough samples, when the edge arrives. Frames carry the
+ * kernel timestamp of that edge. The timer keeps running as a watchdog
+ * that samples anyway if the interrupts stop. Without an interrupt line,
+ * status polling reads INT_STATUS along with the data and drops frames the
+ * chip has not refreshed.
+ *
+ * An overflowed FIFO, or one whose count says the read pointer slipped into
+ * a packet, is resynchronized keeping every whole packet it still holds.
+ * Lost samples are reported on the next frame (QMPU6050Frame::gap) and
+ * through gapDetected() instead of delivering misaligned garbage.
+ *
+ * Whenever the number of new samples is known, i.e. in FIFOMode, with
+ * interrupts or with status polling, frames are timestamped by a
+ * QMPU6050Timestamper that tracks the chip's sample clock, so each sample
+ * of a FIFO batch gets its own time and oscillator drift is compensated.
+ *
+ * Listeners asking for FixedPointOutput receive QMPU6050FixedFrame. While
+ * no listener wants floating point the conversion is skipped altogether.
+ *
+ * Bus errors during sampling are handled on the sampling thread by an
+ * escalating policy: the cycle is retried with doubling backoff, then the
+ * bus is reopened and the chip checked, and finally the configuration is
+ * restored from the register shadow. Each stage runs on a later sampling
+ * cycle once its backoff expired, so the sampling thread never sleeps while
+ * holding its lock. errorOccurred() is only emitted once all of that failed;
+ * sampling then retries recovery once per second.
+ */
+class QMPU6_5__EXPORT QMPU6050Acquisition : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode
+    {
+        PollingMode,
+        FIFOMode
+    };
+    Q_ENUM(Mode)
+
+    enum OutputFormat
+    {
+        FloatingPointOutput,
+        FixedPointOutput
+    };
+    Q_ENUM(OutputFormat)
+
+    enum Source
+    {
+        NoSource = 0x0,
+        Accelerometer = 0x1,
+        Temperature = 0x2,
+        Gyroscope = 0x4,
+        AllSources = Accelerometer | Temperature | Gyroscope
+    };
+    Q_DECLARE_FLAGS(Sources, Source)
+    Q_FLAG(Sources)
+
+    enum FaultState
+    {
+        HealthyState,
+        RetryingState,
+        ReopeningState,
+        ReinitializingState,
+        FailedState
+    };
+    Q_ENUM(FaultState)
+
+    struct FaultStatistics
+    {
+        quint64 faults = 0;            //sampling cycles that hit a bus error
+        quint64 retries = 0;
+        quint64 reopens = 0;
+        quint64 reinitializations = 0;
+        quint64 recoveries = 0;
+        quint64 failures = 0;          //escalations that ended in FailedState
+        int lastError = 0;
+    };
+
+    static QMPU6050Acquisition *acquire(const QString &bus, quint8 address);
+    static void release(QMPU6050Acquisition *acquisition);
+
+    void attach(QMPU6050FrameListener *listener, qreal rate, Sources sources = AllSources, Mode mode = PollingMode);
+    void detach(QMPU6050FrameListener *listener);
+    void setRate(QMPU6050FrameListener *listener, qreal rate);
+    void setMode(QMPU6050FrameListener *listener, Mode mode);
+    void setOutputFormat(QMPU6050FrameListener *listener, OutputFormat format);
+    bool isAttached(QMPU6050FrameListener *listener) const;
+
+    qreal rate() const;
+    Mode mode() const;
+    Sources sources() const;
+    quint16 packetSize() const;
+    bool isFloatingPoint() const;
+    bool isActive() const;
+
+    static qreal maximumRate(Mode mode, Sources sources);
+    static quint16 packetSize(Sources sources);
+
+    QString bus() const;
+    quint8 address() const;
+    QI2CDevice *device() const;
+
+    void setThreaded(bool threaded);
+    bool isThreaded() const;
+    QMPU6050AcquisitionThread *acquisitionThread() const;
+
+    void configure(const QObject *sensor);
+
+    void setInterruptSource(QInterruptSource *source);
+    QInterruptSource *interruptSource() const;
+    bool isInterruptDriven() const;
+    quint64 interruptCount() const;
+    quint64 interruptTimeoutCount() const;
+
+    void setStatusPolling(bool enabled);
+    bool isStatusPolling() const;
+    quint64 dataReadyCount() const;
+    quint64 duplicateSampleCount() const;
+    quint64 missedSampleCount() const;
+
+    QMPU6050Timestamper timestamper() const;
+
+    void requestResync();
+    quint64 fifoOverflowCount() const;
+    quint64 fifoResyncCount() const;
+    quint64 gapCount() const;
+    quint64 lostSampleCount() const;
+
+    quint64 overrunCount() const;
+
+    QMPU6050FrameRing *frameRing();
+
+    QMPU6050Frame lastFrame() const;
+    QMPU6050Batch lastBatch() const;
+
+    FaultState faultState() const;
+    FaultStatistics faultStatistics() const;
+    void setRetryPolicy(int retries, quint64 backoff, quint64 backoffLimit);
+    void requestRecovery(int error);
+
+    static void configureRegisterShadow(QI2CDevice *device);
+
+    static quint64 timestamp();
+    void setAccelerometerRange(quint8 range);
+    void setGyroscopeRange(quint8 range);
+    const QMPU6050Decoder::Scale *scale() const;
+
+    static void decode(const quint8 *buffer, QMPU6050Frame *frame, const QMPU6050Decoder::Scale &scale = QMPU6050Decoder::Scale());
+    static void decode(const quint8 *buffer, Sources sources, QMPU6050Frame *frame, const QMPU6050Decoder::Scale &scale = QMPU6050Decoder::Scale());
+    static void decodeRaw(const quint8 *buffer, Sources sources, QMPU6050Frame *frame);
+    static QMPU6050FixedFrame fixedFrame(const QMPU6050Frame &frame);
+
+signals:
+    void frameReady(const QMPU6050Frame &frame);
+    void fixedFrameReady(const QMPU6050FixedFrame &frame);
+    void batchReady(const QMPU6050Batch &batch);
+    void errorOccurred(int error);
+    void faultStateChanged(QMPU6050Acquisition::FaultState state, int error);
+    void gapDetected(quint64 timestamp, quint32 lostSamples);
+
+protected slots:
+    void poll();
+    void dispatch();
+    void interrupted();
+
+private:
+    struct Listener
+    {
+        QMPU6050FrameListener *listener = nullptr;
+        qreal rate = 1;
+        Sources sources = AllSources;
+        Mode mode = PollingMode;
+        OutputFormat format = FloatingPointOutput;
+        quint32 divider = 1;
+        quint32 counter = 0;
+    };
+
+    QMPU6050Acquisition(const QString &bus, quint8 address);
+    ~QMPU6050Acquisition();
+
+    friend class QMPU6050AcquisitionThread;
+
+    bool sample();
+    bool sampleOnTimeout();
+    bool serviceInterrupt();
+    bool readSamples();
+    bool drain();
+    bool updateScale();
+    bool resynchronize(bool overflow, quint64 now);
+    void queuePackets(const quint8 *buffer, quint16 packets, quint32 lost, quint64 now);
+    void decoded(quint16 index, QMPU6050Frame *frame) const;
+    void updateTimestamps(quint32 samples, quint64 now);
+
+    bool fault(int error);
+    bool recover();
+    bool recovered();
+    bool escalate(FaultState state, int error, quint64 deadline);
+    bool verify();
+    bool reopen();
+    bool reinitialize();
+    void setFaultState(FaultState state, int error);
+    void scheduleDispatch();
+    quint64 interval() const;
+
+    void updateInterval();
+    void deliver();
+    void deliverBatch();
+    QMPU6050Batch *nextBatch();
+
+    bool enableFIFO();
+    bool disableFIFO();
+    bool enableInterrupt();
+    bool disableInterrupt();
+    bool enableDataReady(bool anyReadClears);
+    bool disableDataReady();
+
+    static qreal sampleRateSettings(qreal rate, quint8 *divider, quint8 *dlpfMode);
+    static qreal sampleRateDivider(qreal rate, quint8 dlpfMode, quint8 *divider);
+
+    QString m_bus;
+    quint8 m_address = 0x68;
+    qint32 m_refCount = 0;
+
+    QI2CDevice *m_i2c = nullptr;
+    QTimer *m_pollTimer = nullptr;
+
+    QList<Listener> m_listeners;
+    qreal m_rate = 0;
+    quint64 m_interval = 0; //microseconds between sampling cycles or watchdog checks, 0 when idle
+    Mode m_mode = PollingMode;
+    Sources m_sources = AllSources;
+    bool m_floatingPoint = true; //some listener wants scaled values
+    bool m_fixedPoint = false;   //some listener wants QMPU6050FixedFrame
+
+    //FIFO streaming state, valid while m_fifoActive is set
+    bool m_fifoActive = false;
+    quint8 m_sampleRateDivider = 0;
+    quint8 m_dlpfMode = MPU6050_DLPF_BW_188;
+    quint8 m_fifoSources = 0;
+    quint16 m_packetSize = 14;
+    quint8 m_fifoBuffer[MPU6050_FIFO_SIZE];
+    float m_decodedValues[QMPU6050Decoder::ChannelCount][MPU6050_FIFO_SIZE / 12];
+    qint16 m_decodedRaw[QMPU6050Decoder::ChannelCount][MPU6050_FIFO_SIZE / 12];
+    quint16 m_fifoRemainder = 0;     //FIFO_COUNT modulo the packet size at the last drain
+    quint32 m_misalignedDrains = 0;
+    quint32 m_pendingGap = 0;        //lost samples to report on the next frame
+    QAtomicInteger<int> m_resyncRequested = 0;
+    quint64 m_fifoOverflowCount = 0;
+    quint64 m_fifoResyncCount = 0;
+    quint64 m_gapCount = 0;
+    quint64 m_lostSampleCount = 0;
+
+    //interrupt driven sampling, the source is owned by the engine
+    QInterruptSource *m_interrupt = nullptr;
+    QSocketNotifier *m_interruptNotifier = nullptr;
+    bool m_interruptActive = false;
+    quint32 m_interruptsPerDrain = 1;
+    quint32 m_pendingInterrupts = 0;
+    quint64 m_lastInterrupt = 0;  //microseconds, CLOCK_MONOTONIC
+    quint64 m_eventTimestamp = 0; //edge that triggered the current cycle, 0 if timer driven
+    quint32 m_eventSamples = 0;   //edges since the previous cycle
+    quint64 m_interruptCount = 0;
+    quint64 m_interruptTimeoutCount = 0;
+
+    //DATA_RDY status polling without an interrupt line
+    bool m_statusPolling = false;
+    bool m_statusPollingActive = false;
+    quint64 m_lastDataReady = 0; //microseconds, CLOCK_MONOTONIC
+    quint64 m_dataReadyCount = 0;
+    quint64 m_duplicateSampleCount = 0;
+    quint64 m_missedSampleCount = 0;
+
+    //producer side, owned by whichever thread runs sample()
+    QMPU6050AcquisitionThread *m_thread = nullptr;
+    QMPU6050Frame m_sampleFrame;
+    QMPU6050Timestamper m_timestamper;
+    QAtomicPointer<const QMPU6050Decoder::Scale> m_scale = QMPU6050Decoder::nativeScale(0, 0);
+    quint64 m_lastRead = 0; //microseconds, CLOCK_MONOTONIC
+    QSPSCQueue<QMPU6050Frame, 4096> m_queue;
+    QMPU6050FrameRing m_frameRing;
+    QAtomicInteger<int> m_dispatchPending = 0;
+
+    //fault handling, runs with sampling on the producer thread
+    QAtomicInteger<int> m_faultState = HealthyState;
+    QAtomicInteger<int> m_recoveryRequested = 0; //errno of the request, 0 if none
+    FaultStatistics m_faults;
+    int m_retryLimit = 3;
+    quint64 m_retryBackoff = 100;       //microseconds before the first retry
+    quint64 m_retryBackoffLimit = 1000;
+    int m_retryCount = 0;
+    quint64 m_nextBackoff = 0;
+    quint64 m_nextRecovery = 0;         //microseconds, the next recovery stage is due
+
+    //consumer side. batches are pooled so a receiver holding on to one does
+    //not make the next dispatch detach and reallocate
+    static constexpr int batchPoolSize = 4;
+
+    QMPU6050Frame m_frame;
+    QMPU6050Batch m_batches[batchPoolSize];
+    QMPU6050Batch *m_batch = &m_batches[0];
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(QMPU6050Acquisition::Sources)
+
+QT_END_NAMESPACE
+
+#endif // QMPU6_5_ACQUISITION_H
@@ -0,0 +1,346 @@
+#include "qmpu6050acquisitionthread.h"
+#include "qmpu6050acquisition.h"
+
+#include <QDebug>
+#include <QVarLengthArray>
+
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+//registry of threads keyed by bus path
+static QMutex registryMutex;
+static QHash<QString, QMPU6050AcquisitionThread*> registry;
+
+//longest uninterrupted sleep without a wake up eventfd, bounds how late
+//add() and stop requests are noticed
+static const quint64 sleepLimit = 100000;
+
+QMPU6050AcquisitionThread::QMPU6050AcquisitionThread(const QString &bus)
+    : QThread{nullptr}
+{
+    m_bus = bus;
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if(m_wakeFd < 0)
+        qDebug() << QString("COULD NOT CREATE WAKE UP EVENT FOR %1: %2").arg(m_bus, strerror(errno));
+}
+
+QMPU6050AcquisitionThread::~QMPU6050AcquisitionThread()
+{
+    requestInterruption();
+
+    m_mutex.lock();
+    wake();
+    m_mutex.unlock();
+
+    wait();
+
+    if(m_wakeFd >= 0)
+        ::close(m_wakeFd);
+}
+
+QMPU6050AcquisitionThread *QMPU6050AcquisitionThread::acquire(const QString &bus)
+{
+    QMutexLocker locker(&registryMutex);
+
+    QMPU6050AcquisitionThread *thread = registry.value(bus, nullptr);
+
+    if(!thread)
+    {
+        thread = new QMPU6050AcquisitionThread(bus);
+        registry.insert(bus, thread);
+        thread->start();
+    }
+
+    ++thread->m_refCount;
+
+    return thread;
+}
+
+void QMPU6050AcquisitionThread::release(QMPU6050AcquisitionThread *thread)
+{
+    if(!thread)
+        return;
+
+    QMutexLocker locker(&registryMutex);
+
+    if(--thread->m_refCount > 0)
+        return;
+
+    registry.remove(thread->m_bus);
+    delete thread;
+}
+
+/*!
+ * Starts sampling \a acquisition on this thread. Blocks while a sampling
+ * cycle is in progress.
+ */
+void QMPU6050AcquisitionThread::add(QMPU6050Acquisition *acquisition)
+{
+    QMutexLocker locker(&m_mutex);
+
+    for(const Entry &entry : m_entries)
+    {
+        if(entry.acquisition == acquisition)
+            return;
+    }
+
+    Entry entry;
+    entry.acquisition = acquisition;
+
+    m_entries.append(entry);
+    wake();
+}
+
+/*!
+ * Stops sampling \a acquisition. Once this returns the thread no longer
+ * touches the engine.
+ */
+void QMPU6050AcquisitionThread::remove(QMPU6050Acquisition *acquisition)
+{
+    QMutexLocker locker(&m_mutex);
+
+    for(qsizetype i = 0; i < m_entries.count(); ++i)
+    {
+        if(m_entries[i].acquisition == acquisition)
+        {
+            m_entries.removeAt(i);
+            break;
+        }
+    }
+}
+
+/*!
+ * Restarts the deadline sequence of \a acquisition after its interval
+ * changed. The caller must hold mutex().
+ */
+void QMPU6050AcquisitionThread::reschedule(QMPU6050Acquisition *acquisition)
+{
+    for(Entry &entry : m_entries)
+    {
+        if(entry.acquisition == acquisition)
+            entry.deadline = 0;
+    }
+
+    wake();
+}
+
+/*!
+ * Gets the thread out of its idle wait or its sleep. The caller must hold
+ * mutex().
+ */
+void QMPU6050AcquisitionThread::wake()
+{
+    m_wake.wakeAll();
+
+    if(m_wakeFd < 0)
+        return;
+
+    quint64 one = 1;
+    ::write(m_wakeFd, &one, sizeof(one));
+}
+
+QMutex *QMPU6050AcquisitionThread::mutex()
+{
+    return &m_mutex;
+}
+
+QString QMPU6050AcquisitionThread::bus() const
+{
+    return m_bus;
+}
+
+QMPU6050AcquisitionThread::SchedulingPolicy QMPU6050AcquisitionThread::schedulingPolicy() const
+{
+    return m_policy;
+}
+
+void QMPU6050AcquisitionThread::setSchedulingPolicy(SchedulingPolicy policy)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_policy = policy;
+    m_schedulingChanged.storeRelease(1);
+    wake();
+}
+
+int QMPU6050AcquisitionThread::schedulingPriority() const
+{
+    return m_priority;
+}
+
+void QMPU6050AcquisitionThread::setSchedulingPriority(int priority)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_priority = priority;
+    m_schedulingChanged.storeRelease(1);
+    wake();
+}
+
+int QMPU6050AcquisitionThread::cpuAffinity() const
+{
+    return m_cpu;
+}
+
+/*!
+ * Pins the thread to \a cpu, -1 leaves the affinity alone. Returns false and
+ * keeps the current affinity if \a cpu is not a CPU of this system.
+ */
+bool QMPU6050AcquisitionThread::setCpuAffinity(int cpu)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+
+    if(cpu < -1 || cpu >= CPU_SETSIZE || (cpus > 0 && cpu >= cpus))
+    {
+        qDebug() << QString("CPU %1 DOES NOT EXIST, NOT PINNING %2").arg(cpu).arg(m_bus);
+        errno = EINVAL;
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    m_cpu = cpu;
+    m_schedulingChanged.storeRelease(1);
+    wake();
+
+    return true;
+}
+
+void QMPU6050AcquisitionThread::run()
+{
+    QMutexLocker locker(&m_mutex);
+
+    applyScheduling();
+
+    while(!isInterruptionRequested())
+    {
+        if(m_schedulingChanged.loadAcquire())
+            applyScheduling();
+
+        quint64 next = 0;
+
+        //schedule changes and interrupt driven engines wake the thread
+        //through their event fds, interrupted[i] owns descriptors[i + 1]
+        QVarLengthArray<struct pollfd, 8> descriptors;
+        QVarLengthArray<QMPU6050Acquisition*, 8> interrupted;
+
+        descriptors.append({ m_wakeFd, POLLIN, 0 });
+
+        for(Entry &entry : m_entries)
+        {
+            quint64 interval = entry.acquisition->interval();
+
+            //engines without listeners stay idle
+            if(interval == 0)
+                continue;
+
+            if(entry.acquisition->isInterruptDriven())
+            {
+                descriptors.append({ entry.acquisition->interruptSource()->handle(), POLLIN, 0 });
+                interrupted.append(entry.acquisition);
+            }
+
+            quint64 now = QMPU6050Acquisition::timestamp();
+
+            if(entry.deadline <= now)
+            {
+                entry.acquisition->sampleOnTimeout();
+
+                //advance on the original grid, skip slots that were missed entirely
+                entry.deadline = entry.deadline ? entry.deadline + interval : now + interval;
+
+                if(entry.deadline <= now)
+                    entry.deadline = now + interval;
+            }
+
+            if(next == 0 || entry.deadline < next)
+                next = entry.deadline;
+        }
+
+        if(next == 0)
+        {
+            m_wake.wait(&m_mutex);
+            continue;
+        }
+
+        locker.unlock();
+
+        quint64 deadline = m_wakeFd < 0 ? qMin(next, QMPU6050Acquisition::timestamp() + sleepLimit) : next;
+
+        //ppoll() skips the negative fd if the wake up event is missing
+        waitUntil(descriptors.data(), static_cast<int>(descriptors.size()), deadline);
+
+        locker.relock();
+
+        if(descriptors[0].revents & POLLIN)
+        {
+            quint64 counter = 0;
+            ::read(m_wakeFd, &counter, sizeof(counter));
+        }
+
+        for(qsizetype i = 0; i < interrupted.size(); ++i)
+        {
+            if(!(descriptors[i + 1].revents & POLLIN))
+                continue;
+
+            //the engine may have been removed while the lock was released
+            for(Entry &entry : m_entries)
+            {
+                if(entry.acquisition == interrupted[i] && entry.acquisition->isInterruptDriven())
+                    entry.acquisition->serviceInterrupt();
+            }
+        }
+    }
+}
+
+void QMPU6050AcquisitionThread::applyScheduling()
+{
+    m_schedulingChanged.storeRelease(0);
+
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+
+    //SCHED_OTHER only accepts priority 0
+    if(m_policy != OtherPolicy)
+        param.sched_priority = qBound(sched_get_priority_min(m_policy), m_priority, sched_get_priority_max(m_policy));
+
+    int result = pthread_setschedparam(pthread_self(), m_policy, &param);
+
+    if(result != 0)
+        qDebug() << QString("COULD NOT SET SCHEDULING POLICY %1 PRIORITY %2 ON %3: %4").arg(m_policy).arg(param.sched_priority).arg(m_bus, strerror(result));
+
+    if(m_cpu < 0)
+        return;
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(m_cpu, &cpus);
+
+    result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+    if(result != 0)
+        qDebug() << QString("COULD NOT PIN %1 TO CPU %2: %3").arg(m_bus).arg(m_cpu).arg(strerror(result));
+}
+
+/*!
+ * Waits for any of \a descriptors to become readable, at most until the
+ * absolute CLOCK_MONOTONIC time \a deadline in microseconds.
+ */
+void QMPU6050AcquisitionThread::waitUntil(struct pollfd *descriptors, int count, quint64 deadline)
+{
+    quint64 now = QMPU6050Acquisition::timestamp();
+    quint64 timeout = deadline > now ? deadline - now : 0;
+
+    struct timespec time;
+    time.tv_sec = static_cast<time_t>(timeout / 1000000);
+    time.tv_nsec = static_cast<long>((timeout % 1000000) * 1000);
+
+    while(ppoll(descriptors, static_cast<nfds_t>(count), &time, nullptr) < 0 && errno == EINTR)
+        ;
+}
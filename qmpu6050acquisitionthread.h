@@ -0,0 +1,101 @@
+#ifndef QMPU6_5_ACQUISITIONTHREAD_H
+#define QMPU6_5_ACQUISITIONTHREAD_H
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInteger>
+
+#include "qmpu6050_global.h"
+
+#include <sched.h>
+
+QT_BEGIN_NAMESPACE
+
+class QMPU6050Acquisition;
+
+/*!
+ * \brief Real-time sampling thread shared by every acquisition engine on a bus
+ *
+ * The thread sleeps in ppoll() until the next deadline of its engines, an
+ * interrupt edge or a schedule change, performs the I2C work and decoding of
+ * the due engines and hands the frames to the consumer thread through each
+ * engine's lock-free queue. Deadlines advance by whole periods so sleeping
+ * jitter does not accumulate; a missed deadline skips ahead instead of
+ * bursting.
+ *
+ * Scheduling policy, priority and CPU affinity apply to the whole thread.
+ * Real-time policies usually need CAP_SYS_NICE; a refused request is
+ * reported and the thread keeps running with its previous settings.
+ */
+class QMPU6_5__EXPORT QMPU6050AcquisitionThread : public QThread
+{
+    Q_OBJECT
+public:
+    enum SchedulingPolicy
+    {
+        OtherPolicy = SCHED_OTHER,
+        FIFOPolicy = SCHED_FIFO,
+        RoundRobinPolicy = SCHED_RR
+    };
+    Q_ENUM(SchedulingPolicy)
+
+    static QMPU6050AcquisitionThread *acquire(const QString &bus);
+    static void release(QMPU6050AcquisitionThread *thread);
+
+    void add(QMPU6050Acquisition *acquisition);
+    void remove(QMPU6050Acquisition *acquisition);
+    void reschedule(QMPU6050Acquisition *acquisition);
+
+    QMutex *mutex();
+
+    QString bus() const;
+
+    SchedulingPolicy schedulingPolicy() const;
+    void setSchedulingPolicy(SchedulingPolicy policy);
+
+    int schedulingPriority() const;
+    void setSchedulingPriority(int priority);
+
+    int cpuAffinity() const;
+    bool setCpuAffinity(int cpu);
+
+protected:
+    virtual void run() override;
+
+private:
+    struct Entry
+    {
+        QMPU6050Acquisition *acquisition = nullptr;
+        quint64 deadline = 0; //microseconds, CLOCK_MONOTONIC. 0 samples immediately
+    };
+
+    explicit QMPU6050AcquisitionThread(const QString &bus);
+    ~QMPU6050AcquisitionThread();
+
+    void applyScheduling();
+    void wake();
+    static void waitUntil(struct pollfd *descriptors, int count, quint64 deadline);
+
+    QString m_bus;
+    qint32 m_refCount = 0;
+
+    //guards m_entries and the engines' sampling state
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    QList<Entry> m_entries;
+    int m_wakeFd = -1; //eventfd that cuts the sleep short when the schedule changes
+
+    SchedulingPolicy m_policy = OtherPolicy;
+    int m_priority = 0;
+    int m_cpu = -1; //-1 leaves the affinity alone
+    QAtomicInteger<int> m_schedulingChanged = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QMPU6_5_ACQUISITIONTHREAD_H
@@ -1,17 +1,18 @@
 #include "qmpu6050backend.h"
 
+#include <string.h>
+
 QMPU6050Backend::QMPU6050Backend(QSensor *sensor)
     : QSensorBackend{sensor}
 {
-    m_pollTimer = new QTimer(this);
-    QObject::connect(m_pollTimer, SIGNAL(timeout()), this, SLOT(poll()));
-
     QMPU6050 *child = qobject_cast<QMPU6050*>(sensor);
 
     if(child)
     {
         m_sensor = child;
+        m_fifoStreaming = child->isFIFOStreaming();
         m_i2c = new QI2CDevice(child->bus(), child->address());
+        QMPU6050Acquisition::configureRegisterShadow(m_i2c);
 
         reportEvent("QMPU6050 BACKEND CREATED");
 
@@ -20,38 +21,38 @@ QMPU6050Backend::QMPU6050Backend(QSensor *sensor)
 
         child->m_controller = this;
 
-        addDataRate(1, 157);
+        //rates above the polling limit need FIFO streaming, the engine clamps otherwise
+        addDataRate(1, QMPU6050Acquisition::maximumRate(QMPU6050Acquisition::FIFOMode, QMPU6050Acquisition::AllSources));
+
+        attachAcquisition();
     }
 }
 
 QMPU6050Backend::~QMPU6050Backend()
 {
-    if(m_pollTimer)
-    {
-        if(m_pollTimer->isActive())
-            m_pollTimer->stop();
+    releaseAcquisition();
 
-        delete m_pollTimer;
-    }
+    //closes the persistent i2c connection
+    if(m_i2c)
+        delete m_i2c;
 
     QSensorBackend::~QSensorBackend();
 }
 
 void QMPU6050Backend::start()
 {
-    if(m_pollTimer && m_pollTimer->isActive())
+    if(!m_acquisition || m_acquisition->isAttached(this))
         return;
 
-    m_pollTimer->setInterval(1000 / sensor()->dataRate());
-    m_pollTimer->start();
+    m_acquisition->attach(this, sensor()->dataRate(), QMPU6050Acquisition::AllSources, acquisitionMode());
 }
 
 void QMPU6050Backend::stop()
 {
-    if(!m_pollTimer || !m_pollTimer->isActive())
+    if(!m_acquisition || !m_acquisition->isAttached(this))
         return;
 
-    m_pollTimer->stop();
+    m_acquisition->detach(this);
 }
 
 bool QMPU6050Backend::isFeatureSupported(QSensor::Feature feature) const
@@ -59,16 +60,43 @@ bool QMPU6050Backend::isFeatureSupported(QSensor::Feature feature) const
     return false;
 }
 
-void QMPU6050Backend::poll()
+QMPU6050Acquisition *QMPU6050Backend::acquisition() const
 {
-    //start i2c
-    quint16 count = 0;
-    if(!m_i2c->start() || !get6AxisMotion() || !m_i2c->end())
-    {
-        handleFault();
-        return;
-    }
+    return m_acquisition;
+}
+
+/*!
+ * Returns the bus counters of the chip. They cover the acquisition engine
+ * too, since every device on the same bus address shares them.
+ */
+QI2CStatistics QMPU6050Backend::statistics()
+{
+    if(!m_i2c)
+        return QI2CStatistics();
+
+    return m_i2c->statistics();
+}
 
+void QMPU6050Backend::resetStatistics()
+{
+    if(m_i2c)
+        m_i2c->resetStatistics();
+}
+
+void QMPU6050Backend::frameReceived(const QMPU6050Frame &frame)
+{
+    m_ax = frame.acceleration[0];
+    m_ay = frame.acceleration[1];
+    m_az = frame.acceleration[2];
+
+    m_gx = frame.rotation[0];
+    m_gy = frame.rotation[1];
+    m_gz = frame.rotation[2];
+
+    if(m_sensor)
+        m_sensor->m_frames->push(frame);
+
+    m_reading.setTimestamp(frame.timestamp);
     m_reading.setX(m_ax);
     m_reading.setY(m_ay);
     m_reading.setZ(m_az);
@@ -76,9 +104,55 @@ void QMPU6050Backend::poll()
     newReadingAvailable();
 }
 
+void QMPU6050Backend::batchReceived(const QMPU6050Batch &batch)
+{
+    if(m_sensor)
+        emit m_sensor->batchReady(batch);
+}
+
+/*!
+ * Hands a failed register access to the acquisition engine, which checks
+ * and if needed recovers the chip on its own thread before the next cycle.
+ */
 void QMPU6050Backend::handleFault()
 {
-    //TODO
+    if(m_acquisition)
+        m_acquisition->requestRecovery(errno);
+}
+
+/*!
+ * Reports an error the acquisition engine could not recover from.
+ */
+void QMPU6050Backend::handleError(int error)
+{
+    reportError(QString("ACQUISITION FAILED: %1").arg(strerror(error)));
+    sensorError(error);
+}
+
+/*!
+ * Relearns the configuration once the engine brought the chip back after a
+ * reset().
+ */
+void QMPU6050Backend::handleFaultState(QMPU6050Acquisition::FaultState state, int error)
+{
+    Q_UNUSED(error)
+
+    if(state != QMPU6050Acquisition::HealthyState || !m_resetPending)
+        return;
+
+    m_resetPending = false;
+    refreshConfiguration();
+}
+
+/*!
+ * Takes every sample the engine acquires, not only the ones due at the
+ * sensor's data rate, for QMPU6050::frameUpdated() and the throttled
+ * channel properties.
+ */
+void QMPU6050Backend::handleFrame(const QMPU6050Frame &frame)
+{
+    if(m_sensor)
+        m_sensor->updateFrame(frame);
 }
 
 void QMPU6050Backend::reportEvent(QString message)
@@ -107,7 +181,7 @@ void QMPU6050Backend::onSensorBusChanged()
     if(!sensor)
         return;
 
-    m_i2c->setBus(sensor->bus());
+    setBus(sensor->bus());
 }
 
 void QMPU6050Backend::onSensorAddressChanged()
@@ -117,23 +191,82 @@ void QMPU6050Backend::onSensorAddressChanged()
     if(!sensor)
         return;
 
-    m_i2c->setAddress(sensor->address());
+    setAddress(sensor->address());
 }
 
 void QMPU6050Backend::onSesnorDataRateChanged()
 {
-    stop();
-    start();
+    if(m_acquisition && m_acquisition->isAttached(this))
+        m_acquisition->setRate(this, sensor()->dataRate());
+}
+
+/** Switch the shared acquisition engine between register polling and FIFO
+ * streaming. Takes effect immediately when the backend is running.
+ * @param enabled True to stream every sample through the FIFO
+ * @see QMPU6050Acquisition::FIFOMode
+ */
+void QMPU6050Backend::setFIFOStreaming(bool enabled)
+{
+    if(m_fifoStreaming == enabled)
+        return;
+
+    m_fifoStreaming = enabled;
+
+    if(m_acquisition && m_acquisition->isAttached(this))
+        m_acquisition->setMode(this, acquisitionMode());
+}
+
+QMPU6050Acquisition::Mode QMPU6050Backend::acquisitionMode() const
+{
+    if(m_fifoStreaming)
+        return QMPU6050Acquisition::FIFOMode;
+
+    return QMPU6050Acquisition::PollingMode;
+}
+
+void QMPU6050Backend::attachAcquisition()
+{
+    bool active = m_acquisition && m_acquisition->isAttached(this);
+
+    releaseAcquisition();
+
+    m_acquisition = QMPU6050Acquisition::acquire(m_i2c->bus(), static_cast<quint8>(m_i2c->address()));
+    m_acquisition->configure(sensor());
+    QObject::connect(m_acquisition, &QMPU6050Acquisition::errorOccurred, this, &QMPU6050Backend::handleError);
+    QObject::connect(m_acquisition, &QMPU6050Acquisition::frameReady, this, &QMPU6050Backend::handleFrame);
+    QObject::connect(m_acquisition, &QMPU6050Acquisition::faultStateChanged, this, &QMPU6050Backend::handleFaultState);
+
+    if(active)
+        m_acquisition->attach(this, sensor()->dataRate(), QMPU6050Acquisition::AllSources, acquisitionMode());
+}
+
+void QMPU6050Backend::releaseAcquisition()
+{
+    if(!m_acquisition)
+        return;
+
+    m_acquisition->detach(this);
+    QObject::disconnect(m_acquisition, nullptr, this, nullptr);
+    QMPU6050Acquisition::release(m_acquisition);
+    m_acquisition = nullptr;
 }
 
 void QMPU6050Backend::setAddress(quint8 address)
 {
+    if(m_i2c->address() == address)
+        return;
+
     m_i2c->setAddress(address);
+    attachAcquisition();
 }
 
 void QMPU6050Backend::setBus(const QString &bus)
 {
+    if(m_i2c->bus() == bus)
+        return;
+
     m_i2c->setBus(bus);
+    attachAcquisition();
 }
 
 /** Power on and prepare for general usage.
@@ -162,38 +295,18 @@ bool QMPU6050Backend::initialize()
         return false;
     }
 
-    quint8 gyro = 7;
-    if(!m_i2c->write(static_cast<quint8>(0x19), &gyro, 1))
-    {
-        reportError("COULD SET GYRO RANGE");
-        return false;
-    }
+    //power-on configuration goes out as one transaction
+    QI2CTransaction transaction(m_i2c);
 
-    gyro = 1;
-    if(!m_i2c->write(static_cast<quint8>(MPU6050_RA_PWR_MGMT_1), &gyro, 1))
-    {
-        reportError("COULD SET GYRO RANGE");
-        return false;
-    }
-
-    gyro = 0;
-    if(!m_i2c->write(static_cast<quint8>(0x1A), &gyro, 1))
-    {
-        reportError("COULD SET CONFIG");
-        return false;
-    }
+    bool ok = transaction.write(static_cast<quint8>(MPU6050_RA_SMPLRT_DIV), 7)
+              && transaction.write(static_cast<quint8>(MPU6050_RA_PWR_MGMT_1), 1)
+              && transaction.write(static_cast<quint8>(MPU6050_RA_CONFIG), 0)
+              && transaction.write(static_cast<quint8>(MPU6050_RA_GYRO_CONFIG), 24)
+              && transaction.write(static_cast<quint8>(MPU6050_RA_INT_ENABLE), 1);
 
-    gyro = 24;
-    if(!m_i2c->write(static_cast<quint8>(MPU6050_RA_GYRO_CONFIG), &gyro, 1))
+    if(!ok || !transaction.submit())
     {
-        reportError("COULD SET GYRO RANGE");
-        return false;
-    }
-
-    gyro = 1;
-    if(!m_i2c->write(static_cast<quint8>(0x38), &gyro, 1))
-    {
-        reportError("COULD SET GYRO RANGE");
+        reportError("COULD NOT CONFIGURE DEVICE");
         return false;
     }
 
@@ -205,6 +318,12 @@ bool QMPU6050Backend::initialize()
 
     // setIntDataReadyEnabled(true);
 
+    if(!refreshConfiguration())
+    {
+        reportError("COULD NOT READ CONFIGURATION");
+        return false;
+    }
+
     if(!m_i2c->end())
         return false;
 
@@ -224,12 +343,109 @@ bool QMPU6050Backend::initialize()
 bool QMPU6050Backend::testConnection() {
     quint8 id = 0;
 
+    //the answer has to come from the device, not from the configuration cache
+    m_i2c->invalidateShadow(static_cast<quint8>(MPU6050_RA_WHO_AM_I));
+
     if(!getDeviceID(&id))
         return false;
 
     return id == 0b110100;
 }
 
+/** Read the whole configuration of the device in one snapshot.
+ * The shadowed register runs (offsets and fine gain through the interrupt
+ * configuration, USER_CTRL through PWR_MGMT_2, DMP_CFG_* and WHO_AM_I) are
+ * burst-read in one transfer each, then every configuration property is
+ * decoded from the register shadow. Only properties that differ from the
+ * last known value emit their changed signal.
+ *
+ * Afterwards the configuration getters are served from the shadow without
+ * touching the bus until invalidateConfiguration() is called or the device
+ * is reset. Setters keep the shadow current.
+ * @return True/False for successful read
+ * @see invalidateConfiguration()
+ */
+bool QMPU6050Backend::refreshConfiguration()
+{
+    if(!m_i2c->resyncShadow())
+        return false;
+
+    //every getter below is served from the shadow filled above. all of them
+    //run even if one fails, so one bad register does not leave the rest stale
+    static bool (QMPU6050Backend::*const getters[])() =
+    {
+        &QMPU6050Backend::getAuxVDDIOLevel,
+        &QMPU6050Backend::getRate,
+        &QMPU6050Backend::getExternalFrameSync,
+        &QMPU6050Backend::getDLPFMode,
+        &QMPU6050Backend::getFullScaleGyroRange,
+        &QMPU6050Backend::getAccelXSelfTest,
+        &QMPU6050Backend::getAccelYSelfTest,
+        &QMPU6050Backend::getAccelZSelfTest,
+        &QMPU6050Backend::getFullScaleAccelRange,
+        &QMPU6050Backend::getDHPFMode,
+        &QMPU6050Backend::getFreefallDetectionThreshold,
+        &QMPU6050Backend::getFreefallDetectionDuration,
+        &QMPU6050Backend::getMotionDetectionThreshold,
+        &QMPU6050Backend::getMotionDetectionDuration,
+        &QMPU6050Backend::getZeroMotionDetectionThreshold,
+        &QMPU6050Backend::getZeroMotionDetectionDuration,
+        &QMPU6050Backend::getAccelerometerPowerOnDelay,
+        &QMPU6050Backend::getFreefallDetectionCounterDecrement,
+        &QMPU6050Backend::getMotionDetectionCounterDecrement,
+        &QMPU6050Backend::getFIFOEnabled,
+        &QMPU6050Backend::getSleepEnabled,
+        &QMPU6050Backend::getWakeCycleEnabled,
+        &QMPU6050Backend::getTempSensorEnabled,
+        &QMPU6050Backend::getClockSource,
+        &QMPU6050Backend::getWakeFrequency,
+        &QMPU6050Backend::getStandbyXAccelEnabled,
+        &QMPU6050Backend::getStandbyYAccelEnabled,
+        &QMPU6050Backend::getStandbyZAccelEnabled,
+        &QMPU6050Backend::getStandbyXGyroEnabled,
+        &QMPU6050Backend::getStandbyYGyroEnabled,
+        &QMPU6050Backend::getStandbyZGyroEnabled,
+        &QMPU6050Backend::getXGyroOffset,
+        &QMPU6050Backend::getYGyroOffset,
+        &QMPU6050Backend::getZGyroOffset,
+        &QMPU6050Backend::getXFineGain,
+        &QMPU6050Backend::getYFineGain,
+        &QMPU6050Backend::getZFineGain,
+        &QMPU6050Backend::getXAccelOffset,
+        &QMPU6050Backend::getYAccelOffset,
+        &QMPU6050Backend::getZAccelOffset,
+        &QMPU6050Backend::getXGyroOffsetUser,
+        &QMPU6050Backend::getYGyroOffsetUser,
+        &QMPU6050Backend::getZGyroOffsetUser,
+        &QMPU6050Backend::getIntPLLReadyEnabled,
+        &QMPU6050Backend::getIntDMPEnabled,
+        &QMPU6050Backend::getDMPEnabled,
+        &QMPU6050Backend::getDMPConfig1,
+        &QMPU6050Backend::getDMPConfig2,
+    };
+
+    bool result = getDeviceID();
+
+    for(bool (QMPU6050Backend::*getter)() : getters)
+    {
+        if(!(this->*getter)())
+            result = false;
+    }
+
+    return result;
+}
+
+/** Drop the cached configuration.
+ * The next configuration getter or refreshConfiguration() reads the device
+ * again. Needed when something other than this backend, such as the DMP
+ * firmware or another process on the bus, changed the configuration.
+ * @see refreshConfiguration()
+ */
+void QMPU6050Backend::invalidateConfiguration()
+{
+    m_i2c->invalidateShadow();
+}
+
 // AUX_VDDIO register (InvenSense demo code calls this RA_*G_OFFS_TC)
 
 /** Get the auxiliary I2C supply voltage level.
@@ -293,7 +509,7 @@ bool QMPU6050Backend::getRate()
 {
     quint8 buffer;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_SMPLRT_DIV), &buffer, 1))
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_SMPLRT_DIV), &buffer, 1))
         return false;
 
     if(m_sensor && m_sensor->m_gyroscopeRateDivider != buffer)
@@ -486,7 +702,14 @@ bool QMPU6050Backend::getFullScaleGyroRange()
  */
 bool QMPU6050Backend::setFullScaleGyroRange(quint8 range)
 {
-    return m_i2c->writeBits(static_cast<quint8>(MPU6050_RA_GYRO_CONFIG), range, static_cast<quint8>(MPU6050_GCONFIG_FS_SEL_BIT), static_cast<quint8>(MPU6050_GCONFIG_FS_SEL_LENGTH));
+    if(!m_i2c->writeBits(static_cast<quint8>(MPU6050_RA_GYRO_CONFIG), range, static_cast<quint8>(MPU6050_GCONFIG_FS_SEL_BIT), static_cast<quint8>(MPU6050_GCONFIG_FS_SEL_LENGTH)))
+        return false;
+
+    //frames are converted with the new range from now on
+    if(m_acquisition)
+        m_acquisition->setGyroscopeRange(range);
+
+    return true;
 }
 
 // ACCEL_CONFIG register
@@ -635,7 +858,13 @@ bool QMPU6050Backend::getFullScaleAccelRange()
  */
 bool QMPU6050Backend::setFullScaleAccelRange(quint8 range)
 {
-    return m_i2c->writeBits(static_cast<quint8>(MPU6050_RA_ACCEL_CONFIG), range, static_cast<quint8>(MPU6050_ACONFIG_AFS_SEL_BIT), static_cast<quint8>(MPU6050_ACONFIG_AFS_SEL_LENGTH));
+    if(!m_i2c->writeBits(static_cast<quint8>(MPU6050_RA_ACCEL_CONFIG), range, static_cast<quint8>(MPU6050_ACONFIG_AFS_SEL_BIT), static_cast<quint8>(MPU6050_ACONFIG_AFS_SEL_LENGTH)))
+        return false;
+
+    if(m_acquisition)
+        m_acquisition->setAccelerometerRange(range);
+
+    return true;
 }
 /** Get the high-pass filter configuration.
  * The DHPF is a filter module in the path leading to motion detectors (Free
@@ -721,7 +950,7 @@ bool QMPU6050Backend::getFreefallDetectionThreshold()
 {
     quint8 buffer;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_FF_THR), &buffer, 1))
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_FF_THR), &buffer, 1))
         return false;
 
     qint8 result = static_cast<qint8>(buffer);
@@ -767,7 +996,7 @@ bool QMPU6050Backend::getFreefallDetectionDuration()
 {
     quint8 buffer;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_FF_DUR), &buffer, 1))
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_FF_DUR), &buffer, 1))
         return false;
 
     qint8 result = static_cast<qint8>(buffer);
@@ -815,7 +1044,7 @@ bool QMPU6050Backend::getMotionDetectionThreshold()
 {
     quint8 buffer;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_MOT_THR), &buffer, 1))
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_MOT_THR), &buffer, 1))
         return false;
 
     qint8 result = static_cast<qint8>(buffer);
@@ -859,7 +1088,7 @@ bool QMPU6050Backend::getMotionDetectionDuration()
 {
     quint8 buffer;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_MOT_DUR), &buffer, 1))
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_MOT_DUR), &buffer, 1))
         return false;
 
     qint8 result = static_cast<qint8>(buffer);
@@ -913,7 +1142,7 @@ bool QMPU6050Backend::getZeroMotionDetectionThreshold()
 {
     quint8 buffer;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_ZRMOT_THR), &buffer, 1))
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_ZRMOT_THR), &buffer, 1))
         return false;
 
     qint8 result = static_cast<qint8>(buffer);
@@ -958,7 +1187,7 @@ bool QMPU6050Backend::getZeroMotionDetectionDuration()
 {
     quint8 buffer;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_ZRMOT_DUR), &buffer, 1))
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_ZRMOT_DUR), &buffer, 1))
         return false;
 
     qint8 result = static_cast<qint8>(buffer);
@@ -1067,6 +1296,10 @@ bool QMPU6050Backend::getIntFIFOBufferOverflowStatus()
 
     m_fifoOverflow = static_cast<bool>(buffer);
 
+    //reading the status cleared it, make sure the streaming FIFO realigns
+    if(m_fifoOverflow && m_acquisition)
+        m_acquisition->requestResync();
+
     return true;
 }
 /** Get Data Ready interrupt status.
@@ -1125,38 +1358,21 @@ bool QMPU6050Backend::get9AxisMotion()
  */
 bool QMPU6050Backend::get6AxisMotion()
 {
-    quint8 *buffer = new quint8[14];
+    quint8 buffer[14];
 
     if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_ACCEL_XOUT_H), buffer, 14))
-    {
-        delete [] buffer;
         return false;
-    }
-
-    m_ax = ((((qint16)buffer[0]) << 8) | buffer[1]);
-    m_ay = ((((qint16)buffer[2]) << 8) | buffer[3]);
-    m_az = ((((qint16)buffer[4]) << 8) | buffer[5]);
 
-    if(m_ax > 32768)
-        m_ax = (m_ax - 65536) / 16384.0;
-    else
-        m_ax /= 16384.0;
+    QMPU6050Frame frame;
+    QMPU6050Acquisition::decode(buffer, &frame, m_acquisition ? *m_acquisition->scale() : QMPU6050Decoder::Scale());
 
-    if(m_ay > 32768)
-        m_ay = (m_ay - 65536) / 16384.0;
-    else
-        m_ay /= 16384.0;
+    m_ax = frame.acceleration[0];
+    m_ay = frame.acceleration[1];
+    m_az = frame.acceleration[2];
 
-    if(m_az > 32768)
-        m_az = (m_az - 65536) / 16384.0;
-    else
-        m_az /= 16384.0;
-
-    m_gx = ((((qint16)buffer[8]) << 8) | buffer[9]) / 131;
-    m_gy = ((((qint16)buffer[10]) << 8) | buffer[11]) / 131;
-    m_gz = ((((qint16)buffer[12]) << 8) | buffer[13]) / 131;
-
-    delete [] buffer;
+    m_gx = frame.rotation[0];
+    m_gy = frame.rotation[1];
+    m_gz = frame.rotation[2];
 
     return true;
 }
@@ -1198,36 +1414,17 @@ bool QMPU6050Backend::get6AxisMotion()
  */
 bool QMPU6050Backend::getAcceleration()
 {
-    quint8 *buffer = new quint8[6];
+    quint8 buffer[6];
 
     if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_ACCEL_XOUT_H), buffer, 6))
-    {
-        delete [] buffer;
         return false;
-    }
 
     qint16 x = (((qint16)buffer[0]) << 8) | buffer[1];
     qint16 y = (((qint16)buffer[2]) << 8) | buffer[3];
     qint16 z = (((qint16)buffer[4]) << 8) | buffer[5];
-    delete [] buffer;
-
-    if(m_sensor && m_sensor->m_xAcceleration != x)
-    {
-        m_sensor->m_xAcceleration = x;
-        emit m_sensor->xAccelerationChanged();
-    }
-
-    if(m_sensor && m_sensor->m_yAcceleration != y)
-    {
-        m_sensor->m_yAcceleration = y;
-        emit m_sensor->yAccelerationChanged();
-    }
 
-    if(m_sensor && m_sensor->m_zAcceleration != z)
-    {
-        m_sensor->m_zAcceleration = z;
-        emit m_sensor->zAccelerationChanged();
-    }
+    if(m_sensor)
+        m_sensor->setPendingAcceleration(x, y, z);
 
     return true;
 }
@@ -1240,22 +1437,15 @@ bool QMPU6050Backend::getAcceleration()
  */
 bool QMPU6050Backend::getTemperature()
 {
-    quint8 *buffer = new quint8[2];
+    quint8 buffer[2];
 
     if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_TEMP_OUT_H), buffer, 2))
-    {
-        delete [] buffer;
         return false;
-    }
 
     qint16 temperature = (((qint16)buffer[0]) << 8) | buffer[1];
-    delete [] buffer;
 
-    if(m_sensor && m_sensor->m_temperature != temperature)
-    {
-        m_sensor->m_temperature = temperature;
-        emit m_sensor->temperatureChanged();
-    }
+    if(m_sensor)
+        m_sensor->setPendingTemperature(temperature);
 
     return true;
 }
@@ -1296,36 +1486,17 @@ bool QMPU6050Backend::getTemperature()
  */
 bool QMPU6050Backend::getRotation()
 {
-    quint8 *buffer = new quint8[6];
+    quint8 buffer[6];
 
     if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_GYRO_XOUT_H), buffer, 6))
-    {
-        delete [] buffer;
         return false;
-    }
 
     qint16 x = (((qint16)buffer[0]) << 8) | buffer[1];
     qint16 y = (((qint16)buffer[2]) << 8) | buffer[3];
     qint16 z = (((qint16)buffer[4]) << 8) | buffer[5];
-    delete [] buffer;
 
-    if(m_sensor && m_sensor->m_xRotation != x)
-    {
-        m_sensor->m_xRotation = x;
-        emit m_sensor->xRotationChanged();
-    }
-
-    if(m_sensor && m_sensor->m_yRotation != y)
-    {
-        m_sensor->m_yRotation = y;
-        emit m_sensor->yRotationChanged();
-    }
-
-    if(m_sensor && m_sensor->m_zRotation != z)
-    {
-        m_sensor->m_zRotation = z;
-        emit m_sensor->zRotationChanged();
-    }
+    if(m_sensor)
+        m_sensor->setPendingRotation(x, y, z);
 
     return true;
 }
@@ -1729,13 +1900,33 @@ bool QMPU6050Backend::resetSensors()
 // PWR_MGMT_1 register
 
 /** Trigger a full device reset.
- * A small delay of ~50ms may be desirable after triggering a reset.
+ * The chip needs about 100ms before it answers again. This call does not
+ * wait for it: a running acquisition engine waits out the delay in its
+ * recovery and restores its sampling setup, otherwise a timer does. The
+ * configuration properties are refreshed once the chip is back.
  * @see MPU6050_RA_PWR_MGMT_1
  * @see MPU6050_PWR1_DEVICE_RESET_BIT
  */
 bool QMPU6050Backend::reset()
 {
-    return m_i2c->writeBit(static_cast<quint8>(MPU6050_RA_PWR_MGMT_1), static_cast<quint8>(MPU6050_PWR1_DEVICE_RESET_BIT), true);
+    if(!m_i2c->writeBit(static_cast<quint8>(MPU6050_RA_PWR_MGMT_1), static_cast<quint8>(MPU6050_PWR1_DEVICE_RESET_BIT), true))
+        return false;
+
+    //every register is back at its power-on value, relearn them once the reset completed
+    m_i2c->invalidateShadow();
+
+    if(m_acquisition && m_acquisition->isActive())
+    {
+        m_resetPending = true;
+        m_acquisition->requestRecovery(ESTALE);
+        return true;
+    }
+
+    QTimer::singleShot(resetDelay, this, [this]() {
+        refreshConfiguration();
+    });
+
+    return true;
 }
 /** Get sleep mode status.
  * Setting the SLEEP bit in the register puts the device into very low power
@@ -2174,16 +2365,15 @@ bool QMPU6050Backend::setStandbyZGyroEnabled(bool enabled)
  */
 bool QMPU6050Backend::getFIFOCount(quint16 *count)
 {
-    quint8 *buffer = new quint8[2];
+    quint8 buffer[2];
 
     if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_FIFO_COUNTH), buffer, 2))
-    {
-        delete [] buffer;
         return false;
-    }
 
     quint16 result = (((quint16)buffer[0]) << 8) | buffer[1];
-    delete [] buffer;
+
+    if(count)
+        *count = result;
 
     if(m_sensor && m_sensor->m_FIFOCount != result)
     {
@@ -2233,6 +2423,107 @@ bool QMPU6050Backend::getFIFOByte(quint8 *data)
 
     return true;
 }
+/** Drain whole packets from the FIFO buffer.
+ * Reads FIFO_COUNT once and then streams as many complete packets as fit in
+ * \a capacity out of FIFO_R_W using the largest transfers the adapter allows.
+ * Trailing bytes of a partially written packet stay in the FIFO for the next
+ * drain so the stream never loses alignment.
+ * @param data Buffer to receive the packets
+ * @param capacity Size of \a data in bytes
+ * @param length Number of bytes written to \a data
+ * @return True/False for successful read
+ * @see getFIFOPacketSize()
+ * @see getFIFOCount()
+ * @see MPU6050_RA_FIFO_R_W
+ */
+bool QMPU6050Backend::getFIFOBytes(quint8 *data, quint16 capacity, quint16 *length)
+{
+    if(length)
+        *length = 0;
+
+    quint16 packetSize = 0;
+    quint16 count = 0;
+
+    if(!getFIFOPacketSize(&packetSize) || !getFIFOCount(&count))
+        return false;
+
+    if(packetSize == 0 || count == 0)
+        return true;
+
+    quint16 available = qMin(count, capacity);
+    available -= available % packetSize;
+
+    if(available == 0)
+        return true;
+
+    if(!m_i2c->readStream(static_cast<quint8>(MPU6050_RA_FIFO_R_W), data, available))
+        return false;
+
+    if(length)
+        *length = available;
+
+    return true;
+}
+/** Get the size of one FIFO packet in bytes.
+ * Sums the sources enabled in FIFO_EN (and SLV_3_FIFO_EN in I2C_MST_CTRL) in
+ * the order the MPU writes them: accelerometer (6), temperature (2), each gyro
+ * axis (2) and the configured length of each external slave.
+ * @param size Packet size in bytes, 0 if no source is enabled
+ * @return True/False for successful read
+ * @see MPU6050_RA_FIFO_EN
+ * @see MPU6050_RA_I2C_MST_CTRL
+ */
+bool QMPU6050Backend::getFIFOPacketSize(quint16 *size)
+{
+    quint8 sources = 0;
+    quint8 master = 0;
+
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_FIFO_EN), &sources, 1))
+        return false;
+
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_I2C_MST_CTRL), &master, 1))
+        return false;
+
+    quint16 result = 0;
+
+    if(sources & (1 << MPU6050_ACCEL_FIFO_EN_BIT))
+        result += 6;
+    if(sources & (1 << MPU6050_TEMP_FIFO_EN_BIT))
+        result += 2;
+    if(sources & (1 << MPU6050_XG_FIFO_EN_BIT))
+        result += 2;
+    if(sources & (1 << MPU6050_YG_FIFO_EN_BIT))
+        result += 2;
+    if(sources & (1 << MPU6050_ZG_FIFO_EN_BIT))
+        result += 2;
+
+    bool slaves[]
+    {
+        static_cast<bool>(sources & (1 << MPU6050_SLV0_FIFO_EN_BIT)),
+        static_cast<bool>(sources & (1 << MPU6050_SLV1_FIFO_EN_BIT)),
+        static_cast<bool>(sources & (1 << MPU6050_SLV2_FIFO_EN_BIT)),
+        static_cast<bool>(master & (1 << MPU6050_SLV_3_FIFO_EN_BIT))
+    };
+
+    for(quint8 slave = 0; slave < 4; ++slave)
+    {
+        if(!slaves[slave])
+            continue;
+
+        quint8 slaveLength = 0;
+        quint8 slaveRegister = MPU6050_RA_I2C_SLV0_CTRL + slave * MPU6050_RA_I2C_SLV_CTRL_STRIDE;
+
+        if(!m_i2c->readBits(slaveRegister, &slaveLength, static_cast<quint8>(MPU6050_I2C_SLV_LEN_BIT), static_cast<quint8>(MPU6050_I2C_SLV_LEN_LENGTH)))
+            return false;
+
+        result += slaveLength;
+    }
+
+    if(size)
+        *size = result;
+
+    return true;
+}
 /** Write byte to FIFO buffer.
  * @see getFIFOByte()
  * @see MPU6050_RA_FIFO_R_W
@@ -2362,7 +2653,7 @@ bool QMPU6050Backend::getXFineGain()
 {
     quint8 gain = 0;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_X_FINE_GAIN), &gain, 1))
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_X_FINE_GAIN), &gain, 1))
         return false;
 
     if(m_sensor && m_sensor->m_yFineGrain != gain)
@@ -2385,7 +2676,7 @@ bool QMPU6050Backend::getYFineGain()
 {
     quint8 gain = 0;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_Y_FINE_GAIN), &gain, 1))
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_Y_FINE_GAIN), &gain, 1))
         return false;
 
     if(m_sensor && m_sensor->m_yFineGrain != gain)
@@ -2407,7 +2698,7 @@ bool QMPU6050Backend::getZFineGain()
 {
     quint8 gain = 0;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_Z_FINE_GAIN), &gain, 1))
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_Z_FINE_GAIN), &gain, 1))
         return false;
 
     if(m_sensor && m_sensor->m_zFineGrain != gain)
@@ -2427,17 +2718,13 @@ bool QMPU6050Backend::setZFineGain(quint8 gain)
 
 bool QMPU6050Backend::getXAccelOffset()
 {
-    quint8 *buffer = new quint8[2];
+    quint8 buffer[2];
     qint16 offset = 0;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_XA_OFFS_H), buffer, 2))
-    {
-        delete [] buffer;
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_XA_OFFS_H), buffer, 2))
         return false;
-    }
 
     offset = (qint16)buffer[0] << 8 | buffer[1];
-    delete [] buffer;
 
     if(m_sensor && m_sensor->m_xAccelOffset != offset)
     {
@@ -2450,19 +2737,14 @@ bool QMPU6050Backend::getXAccelOffset()
 
 bool QMPU6050Backend::setXAccelOffset(qint16 offset)
 {
-    quint8 *buffer = new quint8[2]
+    quint8 buffer[2]
     {
         static_cast<quint8>(offset >> 8),
         static_cast<quint8>(offset)
     };
 
     if(!m_i2c->write(static_cast<quint8>(MPU6050_RA_XA_OFFS_H), buffer, 2))
-    {
-        delete [] buffer;
         return false;
-    }
-
-    delete [] buffer;
 
     return true;
 }
@@ -2471,17 +2753,13 @@ bool QMPU6050Backend::setXAccelOffset(qint16 offset)
 
 bool QMPU6050Backend::getYAccelOffset()
 {
-    quint8 *buffer = new quint8[2];
+    quint8 buffer[2];
     qint16 offset = 0;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_YA_OFFS_H), buffer, 2))
-    {
-        delete [] buffer;
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_YA_OFFS_H), buffer, 2))
         return false;
-    }
 
     offset = (qint16)buffer[0] << 8 | buffer[1];
-    delete [] buffer;
 
     if(m_sensor && m_sensor->m_yAccelOffset != offset)
     {
@@ -2493,19 +2771,14 @@ bool QMPU6050Backend::getYAccelOffset()
 }
 bool QMPU6050Backend::setYAccelOffset(qint16 offset)
 {
-    quint8 *buffer = new quint8[2]
+    quint8 buffer[2]
     {
         static_cast<quint8>(offset >> 8),
         static_cast<quint8>(offset)
     };
 
     if(!m_i2c->write(static_cast<quint8>(MPU6050_RA_YA_OFFS_H), buffer, 2))
-    {
-        delete [] buffer;
         return false;
-    }
-
-    delete [] buffer;
 
     return true;
 }
@@ -2514,17 +2787,13 @@ bool QMPU6050Backend::setYAccelOffset(qint16 offset)
 
 bool QMPU6050Backend::getZAccelOffset()
 {
-    quint8 *buffer = new quint8[2];
+    quint8 buffer[2];
     qint16 offset = 0;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_ZA_OFFS_H), buffer, 2))
-    {
-        delete [] buffer;
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_ZA_OFFS_H), buffer, 2))
         return false;
-    }
 
     offset = (qint16)buffer[0] << 8 | buffer[1];
-    delete [] buffer;
 
     if(m_sensor && m_sensor->m_zAccelOffset != offset)
     {
@@ -2536,19 +2805,15 @@ bool QMPU6050Backend::getZAccelOffset()
 }
 bool QMPU6050Backend::setZAccelOffset(qint16 offset)
 {
-    quint8 *buffer = new quint8[2]
+    quint8 buffer[2]
     {
         static_cast<quint8>(offset >> 8),
         static_cast<quint8>(offset)
     };
 
     if(!m_i2c->write(static_cast<quint8>(MPU6050_RA_ZA_OFFS_H), buffer, 2))
-    {
-        delete [] buffer;
         return false;
-    }
 
-    delete [] buffer;
 
     if(m_sensor && m_sensor->m_zAccelOffset != offset)
     {
@@ -2563,17 +2828,13 @@ bool QMPU6050Backend::setZAccelOffset(qint16 offset)
 
 bool QMPU6050Backend::getXGyroOffsetUser()
 {
-    quint8 *buffer = new quint8[2];
+    quint8 buffer[2];
     qint16 offset = 0;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_XG_OFFS_USRH), buffer, 2))
-    {
-        delete [] buffer;
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_XG_OFFS_USRH), buffer, 2))
         return false;
-    }
 
     offset = (qint16)buffer[0] << 8 | buffer[1];
-    delete [] buffer;
 
     if(m_sensor && m_sensor->m_xGyroOffsetUser != offset)
     {
@@ -2585,19 +2846,14 @@ bool QMPU6050Backend::getXGyroOffsetUser()
 }
 bool QMPU6050Backend::setXGyroOffsetUser(qint16 offset)
 {
-    quint8 *buffer = new quint8[2]
+    quint8 buffer[2]
     {
         static_cast<quint8>(offset >> 8),
         static_cast<quint8>(offset)
     };
 
     if(!m_i2c->write(static_cast<quint8>(MPU6050_RA_XG_OFFS_USRH), buffer, 2))
-    {
-        delete [] buffer;
         return false;
-    }
-
-    delete [] buffer;
 
     return true;
 }
@@ -2606,17 +2862,13 @@ bool QMPU6050Backend::setXGyroOffsetUser(qint16 offset)
 
 bool QMPU6050Backend::getYGyroOffsetUser()
 {
-    quint8 *buffer = new quint8[2];
+    quint8 buffer[2];
     qint16 offset = 0;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_YG_OFFS_USRH), buffer, 2))
-    {
-        delete [] buffer;
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_YG_OFFS_USRH), buffer, 2))
         return false;
-    }
 
     offset = (qint16)buffer[0] << 8 | buffer[1];
-    delete [] buffer;
 
     if(m_sensor && m_sensor->m_yGyroOffsetUser != offset)
     {
@@ -2628,19 +2880,14 @@ bool QMPU6050Backend::getYGyroOffsetUser()
 }
 bool QMPU6050Backend::setYGyroOffsetUser(qint16 offset)
 {
-    quint8 *buffer = new quint8[2]
+    quint8 buffer[2]
     {
         static_cast<quint8>(offset >> 8),
         static_cast<quint8>(offset)
     };
 
     if(!m_i2c->write(static_cast<quint8>(MPU6050_RA_YG_OFFS_USRH), buffer, 2))
-    {
-        delete [] buffer;
         return false;
-    }
-
-    delete [] buffer;
 
     return true;
 }
@@ -2649,17 +2896,13 @@ bool QMPU6050Backend::setYGyroOffsetUser(qint16 offset)
 
 bool QMPU6050Backend::getZGyroOffsetUser()
 {
-    quint8 *buffer = new quint8[2];
+    quint8 buffer[2];
     qint16 offset = 0;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_ZG_OFFS_USRH), buffer, 2))
-    {
-        delete [] buffer;
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_ZG_OFFS_USRH), buffer, 2))
         return false;
-    }
 
     offset = (qint16)buffer[0] << 8 | buffer[1];
-    delete [] buffer;
 
     if(m_sensor && m_sensor->m_zGyroOffsetUser != offset)
     {
@@ -2671,19 +2914,14 @@ bool QMPU6050Backend::getZGyroOffsetUser()
 }
 bool QMPU6050Backend::setZGyroOffsetUser(qint16 offset)
 {
-    quint8 *buffer = new quint8[2]
+    quint8 buffer[2]
     {
         static_cast<quint8>(offset >> 8),
         static_cast<quint8>(offset)
     };
 
     if(!m_i2c->write(static_cast<quint8>(MPU6050_RA_ZG_OFFS_USRH), buffer, 2))
-    {
-        delete [] buffer;
         return false;
-    }
-
-    delete [] buffer;
 
     return true;
 }
@@ -2972,13 +3210,10 @@ bool QMPU6050Backend::writeMemoryByte(quint8 data)
 
 bool QMPU6050Backend::readMemoryBlock(quint8 *data, quint16 dataSize, quint8 bank, quint8 address)
 {
-    if(!setMemoryBank(bank))
-        return false;
-
-    if(!setMemoryStartAddress(address))
-        return false;
-
+    //each chunk is BANK_SEL + MEM_START_ADDR + MEM_R_W, as many as fit go out in one ioctl
+    QI2CTransaction transaction(m_i2c);
     quint8 chunkSize;
+
     for (quint16 i = 0; i < dataSize;)
     {
         // determine correct chunk size according to bank position and data size
@@ -2992,48 +3227,41 @@ bool QMPU6050Backend::readMemoryBlock(quint8 *data, quint16 dataSize, quint8 ban
         if (chunkSize > 256 - address)
             chunkSize = 256 - address;
 
-        // read the chunk of data as specified
-        if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_MEM_R_W), data + i, chunkSize))
+        if(transaction.messageCount() + 4 > QI2CTransaction::maxMessages && !transaction.submit())
             return false;
 
+        bool ok = transaction.write(static_cast<quint8>(MPU6050_RA_BANK_SEL), bank & 0x1F)
+                  && transaction.write(static_cast<quint8>(MPU6050_RA_MEM_START_ADDR), address)
+                  && transaction.read(static_cast<quint8>(MPU6050_RA_MEM_R_W), data + i, chunkSize);
+
+        //a chunk that did not fit would leave a hole in data
+        if(!ok)
+        {
+            m_errno = ENOBUFS;
+            return false;
+        }
+
         // increase byte index by [chunkSize]
         i += chunkSize;
 
         // quint8 automatically wraps to 0 at 256
-        address + chunkSize;
-
-        // if we aren't done, update bank (if necessary) and address
-        if (i < dataSize)
-        {
-            if (address == 0)
-                bank++;
+        address += chunkSize;
 
-            if(!setMemoryBank(bank))
-                return false;
-
-            if(!setMemoryStartAddress(address))
-                return false;
-        }
+        if (address == 0)
+            bank++;
     }
 
-    return true;
+    return transaction.submit();
 }
 bool QMPU6050Backend::writeMemoryBlock(quint8 *data, quint16 dataSize, quint8 bank, quint8 address, bool verify)
 {
-    if(!setMemoryBank(bank))
-        return false;
-
-    if(!setMemoryStartAddress(address))
-        return false;
-
+    //each chunk is BANK_SEL + MEM_START_ADDR + MEM_R_W, plus the same again to read it back
+    QI2CTransaction transaction(m_i2c);
+    quint8 verifyBuffer[MPU6050_DMP_MEMORY_CHUNK_SIZE];
     quint8 chunkSize;
-    quint8 *verifyBuffer;
     quint16 i;
     quint8 j;
 
-    if (verify)
-        verifyBuffer = new quint8[MPU6050_DMP_MEMORY_CHUNK_SIZE];
-
     for (i = 0; i < dataSize;)
     {
         // determine correct chunk size according to bank position and data size
@@ -3047,19 +3275,29 @@ bool QMPU6050Backend::writeMemoryBlock(quint8 *data, quint16 dataSize, quint8 ba
         if (chunkSize > 256 - address)
             chunkSize = 256 - address;
 
-        if(!m_i2c->write(static_cast<quint8>(MPU6050_RA_MEM_R_W), data + i, chunkSize))
-            return false;
+        bool ok = transaction.write(static_cast<quint8>(MPU6050_RA_BANK_SEL), bank & 0x1F)
+                  && transaction.write(static_cast<quint8>(MPU6050_RA_MEM_START_ADDR), address)
+                  && transaction.write(static_cast<quint8>(MPU6050_RA_MEM_R_W), data + i, chunkSize);
 
         // verify data if needed
-        if (verify && verifyBuffer)
+        if (verify)
         {
-            if(!setMemoryBank(bank))
-                return false;
+            ok = ok && transaction.write(static_cast<quint8>(MPU6050_RA_BANK_SEL), bank & 0x1F)
+                    && transaction.write(static_cast<quint8>(MPU6050_RA_MEM_START_ADDR), address)
+                    && transaction.read(static_cast<quint8>(MPU6050_RA_MEM_R_W), verifyBuffer, chunkSize);
+        }
 
-            if(!setMemoryStartAddress(address))
-                return false;
+        //a dropped chunk would otherwise go out silently with the rest
+        if(!ok)
+        {
+            m_errno = ENOBUFS;
+            return false;
+        }
 
-            if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_MEM_R_W), verifyBuffer, chunkSize))
+        if (verify)
+        {
+            //the read back has to complete before verifyBuffer is reused
+            if(!transaction.submit())
                 return false;
 
             if (memcmp(data + i, verifyBuffer, chunkSize) != 0)
@@ -3078,43 +3316,31 @@ bool QMPU6050Backend::writeMemoryBlock(quint8 *data, quint16 dataSize, quint8 ba
 
                 stream << QString("\nReceived:");
 
-                for (quint8 j = 0; j < chunkSize; j++)
-                    stream << QString("0x%1 ").arg(verifyBuffer[i + j], 2, 16, '0');
+                for (j = 0; j < chunkSize; j++)
+                    stream << QString("0x%1 ").arg(verifyBuffer[j], 2, 16, '0');
 
                 stream << QString("\n");
 
                 qDebug() << message;
 
-                delete [] verifyBuffer;
-
                 m_errno = EIO;
                 return false; // uh oh.
             }
         }
+        else if(transaction.messageCount() + 3 > QI2CTransaction::maxMessages && !transaction.submit())
+            return false;
 
         // increase byte index by [chunkSize]
         i += chunkSize;
 
         // quint8 automatically wraps to 0 at 256
-        address + chunkSize;
-
-        // if we aren't done, update bank (if necessary) and address
-        if (i < dataSize)
-        {
-            if (address == 0)
-                bank++;
-
-            if(!setMemoryBank(bank))
-                return false;
+        address += chunkSize;
 
-            if(!setMemoryStartAddress(address))
-                return false;
-        }
+        if (address == 0)
+            bank++;
     }
-    if (verify)
-        delete [] verifyBuffer;
 
-    return true;
+    return transaction.submit();
 }
 
 // DMP_CFG_1 register
@@ -3123,7 +3349,7 @@ bool QMPU6050Backend::getDMPConfig1()
 {
     quint8 buffer = 0;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_DMP_CFG_1), &buffer, 1))
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_DMP_CFG_1), &buffer, 1))
         m_errno = errno;
 
     if(m_sensor && m_sensor->m_dmpConfig1 != buffer)
@@ -3152,7 +3378,7 @@ bool QMPU6050Backend::getDMPConfig2()
 {
     quint8 buffer = 0;
 
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_DMP_CFG_2), &buffer, 1))
+    if(!m_i2c->readCached(static_cast<quint8>(MPU6050_RA_DMP_CFG_2), &buffer, 1))
         handleFault();
 
     if(m_sensor && m_sensor->m_dmpConfig2 != buffer)
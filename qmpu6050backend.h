@@ -14,6 +14,8 @@
 #include "qmpu6050.h"
 #include "qmpu6050_p.h"
 #include "qi2cdevice.h"
+#include "qi2ctransaction.h"
+#include "qmpu6050acquisition.h"
 
 #include "fcntl.h"
 #include "i2c/smbus.h"
@@ -25,13 +27,14 @@ QT_BEGIN_NAMESPACE
 
 typedef bool (*QMPUFUNC) ();
 
-class QMPU6_5__EXPORT QMPU6050Backend : public QSensorBackend
+class QMPU6_5__EXPORT QMPU6050Backend : public QSensorBackend, public QMPU6050FrameListener
 {
     Q_OBJECT
 
 public:
     static inline const char* id = "QMPU6050-Backend";
     static inline const quint8 m_chipId = 0x58; //i2c chip id
+    static inline const int resetDelay = 100;   //milliseconds until the chip answers after reset()
 
     explicit QMPU6050Backend(QSensor *sensor = nullptr);
     ~QMPU6050Backend();
@@ -40,9 +43,20 @@ public:
     virtual void stop() override;
     virtual bool isFeatureSupported(QSensor::Feature feature) const override;
 
+    virtual void frameReceived(const QMPU6050Frame &frame) override;
+    virtual void batchReceived(const QMPU6050Batch &batch) override;
+
     bool initialize();
     bool testConnection();
 
+    bool refreshConfiguration();
+    void invalidateConfiguration();
+
+    QMPU6050Acquisition *acquisition() const;
+
+    QI2CStatistics statistics();
+    void resetStatistics();
+
     // AUX_VDDIO register
     bool getAuxVDDIOLevel();
     bool setAuxVDDIOLevel(quint8 level);
@@ -183,6 +197,11 @@ public:
 
     // FIFO_R_W register
     bool getFIFOByte(quint8 *data);
+    bool getFIFOBytes(quint8 *data, quint16 capacity, quint16 *length);
+    bool getFIFOPacketSize(quint16 *size);
+
+    // FIFO streaming acquisition
+    void setFIFOStreaming(bool enabled);
     bool setFIFOByte(quint8 data);
 
     // WHO_AM_I register
@@ -300,11 +319,11 @@ signals:
     void accelerometerDataReady(const qreal &x, const qreal &y, const qreal &z);
     void gyroscopeDataReady(const qreal &x, const qreal &y, const qreal &z);
 
-protected slots:
-    void poll();
-
 protected:
     void handleFault();
+    void handleError(int error);
+    void handleFrame(const QMPU6050Frame &frame);
+    void handleFaultState(QMPU6050Acquisition::FaultState state, int error);
     void reportEvent(QString message);
     void reportError(QString message);
     void newLine();
@@ -313,6 +332,10 @@ protected:
     void onSensorAddressChanged();
     void onSesnorDataRateChanged();
 
+    void attachAcquisition();
+    void releaseAcquisition();
+    QMPU6050Acquisition::Mode acquisitionMode() const;
+
 private:
     QString m_bus = "/dev/i2c-1";
     quint8 m_address = 0x68;
@@ -324,7 +347,10 @@ private:
 
     bool m_initialized = false;
     bool m_backendDebug = true;
-    QTimer *m_pollTimer = nullptr;
+
+    QMPU6050Acquisition *m_acquisition = nullptr;
+    bool m_fifoStreaming = false; //sample through the chip FIFO instead of polling
+    bool m_resetPending = false;  //refresh the configuration once the engine recovered
 
     qreal m_ax = 0;
     qreal m_ay = 0;
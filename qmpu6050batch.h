@@ -0,0 +1,98 @@
+#ifndef QMPU6_5_BATCH_H
+#define QMPU6_5_BATCH_H
+
+#include <QtCore/qglobal.h>
+#include <QMetaType>
+#include <QList>
+#include "qmpu6050_global.h"
+#include "qmpu6050frame.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Block of consecutive samples in structure-of-arrays layout
+ *
+ * Every channel is a contiguous array with one entry per sample, entry i of
+ * each array belongs to the same sampling instant. The arrays are implicitly
+ * shared, so passing a batch through a queued signal does not copy samples.
+ * Units match QMPU6050Frame.
+ */
+struct QMPU6050Batch
+{
+    QList<quint64> timestamp; //microseconds, CLOCK_MONOTONIC
+    quint64 lostSamples = 0;  //sum of the frame gaps, see QMPU6050Frame::gap
+
+    QList<qreal> accelerationX;
+    QList<qreal> accelerationY;
+    QList<qreal> accelerationZ;
+
+    QList<qreal> temperature;
+
+    QList<qreal> rotationX;
+    QList<qreal> rotationY;
+    QList<qreal> rotationZ;
+
+    qsizetype count() const
+    {
+        return timestamp.count();
+    }
+
+    bool isEmpty() const
+    {
+        return timestamp.isEmpty();
+    }
+
+    //true while no copy of the arrays is held elsewhere, clear() and
+    //append() then reuse the storage instead of detaching
+    bool isDetached() const
+    {
+        return timestamp.isDetached()
+            && accelerationX.isDetached() && accelerationY.isDetached() && accelerationZ.isDetached()
+            && temperature.isDetached()
+            && rotationX.isDetached() && rotationY.isDetached() && rotationZ.isDetached();
+    }
+
+    void reserve(qsizetype size)
+    {
+        timestamp.reserve(size);
+        accelerationX.reserve(size);
+        accelerationY.reserve(size);
+        accelerationZ.reserve(size);
+        temperature.reserve(size);
+        rotationX.reserve(size);
+        rotationY.reserve(size);
+        rotationZ.reserve(size);
+    }
+
+    void clear()
+    {
+        timestamp.clear();
+        lostSamples = 0;
+        accelerationX.clear();
+        accelerationY.clear();
+        accelerationZ.clear();
+        temperature.clear();
+        rotationX.clear();
+        rotationY.clear();
+        rotationZ.clear();
+    }
+
+    void append(const QMPU6050Frame &frame)
+    {
+        timestamp.append(frame.timestamp);
+        lostSamples += frame.gap;
+        accelerationX.append(frame.acceleration[0]);
+        accelerationY.append(frame.acceleration[1]);
+        accelerationZ.append(frame.acceleration[2]);
+        temperature.append(frame.temperature);
+        rotationX.append(frame.rotation[0]);
+        rotationY.append(frame.rotation[1]);
+        rotationZ.append(frame.rotation[2]);
+    }
+};
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(QMPU6050Batch)
+
+#endif // QMPU6_5_BATCH_H
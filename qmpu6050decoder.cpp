@@ -0,0 +1,403 @@
+#include "qmpu6050decoder.h"
+
+#include <QAtomicInteger>
+
+#include <array>
+
+#if defined(Q_PROCESSOR_X86) && defined(Q_CC_GNU)
+#include <immintrin.h>
+#define QMPU6050_DECODER_X86
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define QMPU6050_DECODER_NEON
+#endif
+
+namespace {
+
+//channel of every 16-bit lane in a packet, lanes past the packet are padding
+constexpr int accelGyroLanes[8] =
+{
+    QMPU6050Decoder::AccelerationX, QMPU6050Decoder::AccelerationY, QMPU6050Decoder::AccelerationZ,
+    QMPU6050Decoder::RotationX, QMPU6050Decoder::RotationY, QMPU6050Decoder::RotationZ,
+    -1, -1
+};
+
+constexpr int allLanes[8] =
+{
+    QMPU6050Decoder::AccelerationX, QMPU6050Decoder::AccelerationY, QMPU6050Decoder::AccelerationZ,
+    QMPU6050Decoder::Temperature,
+    QMPU6050Decoder::RotationX, QMPU6050Decoder::RotationY, QMPU6050Decoder::RotationZ,
+    -1
+};
+
+template<quint16 PacketSize>
+constexpr const int *lanes()
+{
+    return PacketSize == 14 ? allLanes : accelGyroLanes;
+}
+
+//per lane factor and offset, so a packet is scaled by one multiply-add
+struct LaneScale
+{
+    alignas(32) float factor[8];
+    alignas(32) float offset[8];
+};
+
+template<quint16 PacketSize>
+LaneScale laneScale(const QMPU6050Decoder::Scale &scale)
+{
+    LaneScale result;
+
+    for(int lane = 0; lane < 8; ++lane)
+    {
+        int channel = lanes<PacketSize>()[lane];
+
+        result.offset[lane] = 0;
+
+        if(channel == QMPU6050Decoder::Temperature)
+        {
+            result.factor[lane] = scale.temperature;
+            result.offset[lane] = scale.temperatureOffset;
+        }
+        else if(channel >= QMPU6050Decoder::RotationX)
+            result.factor[lane] = scale.rotation;
+        else if(channel >= 0)
+            result.factor[lane] = scale.acceleration;
+        else
+            result.factor[lane] = 0;
+    }
+
+    return result;
+}
+
+//scatters one decoded packet into the channel arrays
+template<quint16 PacketSize>
+inline void store(const float *values, const qint16 *raw, qsizetype index, QMPU6050Decoder::Output *output)
+{
+    constexpr int laneCount = PacketSize / 2;
+
+    for(int lane = 0; lane < laneCount; ++lane)
+        output->values[lanes<PacketSize>()[lane]][index] = values[lane];
+
+    if(output->raw[QMPU6050Decoder::AccelerationX])
+    {
+        for(int lane = 0; lane < laneCount; ++lane)
+            output->raw[lanes<PacketSize>()[lane]][index] = raw[lane];
+    }
+}
+
+template<quint16 PacketSize>
+void decodeScalar(const quint8 *packets, qsizetype begin, qsizetype count, const LaneScale &scale, QMPU6050Decoder::Output *output)
+{
+    constexpr int laneCount = PacketSize / 2;
+
+    for(qsizetype i = begin; i < count; ++i)
+    {
+        const quint8 *packet = packets + i * PacketSize;
+        float values[laneCount];
+        qint16 raw[laneCount];
+
+        for(int lane = 0; lane < laneCount; ++lane)
+        {
+            raw[lane] = static_cast<qint16>((packet[lane * 2] << 8) | packet[lane * 2 + 1]);
+            values[lane] = raw[lane] * scale.factor[lane] + scale.offset[lane];
+        }
+
+        store<PacketSize>(values, raw, i, output);
+    }
+}
+
+//the vector kernels load 16 bytes per packet, the last packets of the
+//block would read past its end and are left to the scalar kernel
+template<quint16 PacketSize>
+constexpr qsizetype vectorCount(qsizetype count)
+{
+    //packets i with i * PacketSize + 16 <= count * PacketSize
+    return count > 0 ? count - ((16 - PacketSize) + (PacketSize - 1)) / PacketSize : 0;
+}
+
+#ifdef QMPU6050_DECODER_X86
+template<quint16 PacketSize>
+__attribute__((target("ssse3")))
+void decodeSSSE3(const quint8 *packets, qsizetype count, const LaneScale &scale, QMPU6050Decoder::Output *output)
+{
+    const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    const __m128 factorLow = _mm_load_ps(scale.factor);
+    const __m128 factorHigh = _mm_load_ps(scale.factor + 4);
+    const __m128 offsetLow = _mm_load_ps(scale.offset);
+    const __m128 offsetHigh = _mm_load_ps(scale.offset + 4);
+
+    qsizetype vectors = vectorCount<PacketSize>(count);
+
+    for(qsizetype i = 0; i < vectors; ++i)
+    {
+        alignas(16) float values[8];
+        alignas(16) qint16 raw[8];
+
+        __m128i packet = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(packets + i * PacketSize)), swap);
+
+        //sign extension by duplicating each lane and shifting it back down
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(packet, packet), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(packet, packet), 16);
+
+        _mm_store_ps(values, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(low), factorLow), offsetLow));
+        _mm_store_ps(values + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(high), factorHigh), offsetHigh));
+        _mm_store_si128(reinterpret_cast<__m128i*>(raw), packet);
+
+        store<PacketSize>(values, raw, i, output);
+    }
+
+    decodeScalar<PacketSize>(packets, qMax<qsizetype>(0, vectors), count, scale, output);
+}
+
+template<quint16 PacketSize>
+__attribute__((target("avx2")))
+void decodeAVX2(const quint8 *packets, qsizetype count, const LaneScale &scale, QMPU6050Decoder::Output *output)
+{
+    const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    const __m256 factor = _mm256_load_ps(scale.factor);
+    const __m256 offset = _mm256_load_ps(scale.offset);
+
+    qsizetype vectors = vectorCount<PacketSize>(count);
+
+    for(qsizetype i = 0; i < vectors; ++i)
+    {
+        alignas(32) float values[8];
+        alignas(16) qint16 raw[8];
+
+        __m128i packet = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(packets + i * PacketSize)), swap);
+        __m256 converted = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(packet));
+
+        _mm256_store_ps(values, _mm256_add_ps(_mm256_mul_ps(converted, factor), offset));
+        _mm_store_si128(reinterpret_cast<__m128i*>(raw), packet);
+
+        store<PacketSize>(values, raw, i, output);
+    }
+
+    decodeScalar<PacketSize>(packets, qMax<qsizetype>(0, vectors), count, scale, output);
+}
+#endif
+
+#ifdef QMPU6050_DECODER_NEON
+template<quint16 PacketSize>
+void decodeNEON(const quint8 *packets, qsizetype count, const LaneScale &scale, QMPU6050Decoder::Output *output)
+{
+    const float32x4_t factorLow = vld1q_f32(scale.factor);
+    const float32x4_t factorHigh = vld1q_f32(scale.factor + 4);
+    const float32x4_t offsetLow = vld1q_f32(scale.offset);
+    const float32x4_t offsetHigh = vld1q_f32(scale.offset + 4);
+
+    qsizetype vectors = vectorCount<PacketSize>(count);
+
+    for(qsizetype i = 0; i < vectors; ++i)
+    {
+        float values[8];
+        qint16 raw[8];
+
+        int16x8_t packet = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(packets + i * PacketSize)));
+
+        float32x4_t low = vcvtq_f32_s32(vmovl_s16(vget_low_s16(packet)));
+        float32x4_t high = vcvtq_f32_s32(vmovl_s16(vget_high_s16(packet)));
+
+        vst1q_f32(values, vaddq_f32(vmulq_f32(low, factorLow), offsetLow));
+        vst1q_f32(values + 4, vaddq_f32(vmulq_f32(high, factorHigh), offsetHigh));
+        vst1q_s16(raw, packet);
+
+        store<PacketSize>(values, raw, i, output);
+    }
+
+    decodeScalar<PacketSize>(packets, qMax<qsizetype>(0, vectors), count, scale, output);
+}
+#endif
+
+template<quint16 PacketSize>
+void decodeWith(QMPU6050Decoder::Implementation implementation, const quint8 *packets, qsizetype count, const QMPU6050Decoder::Scale &scale, QMPU6050Decoder::Output *output)
+{
+    LaneScale lanes = laneScale<PacketSize>(scale);
+
+    switch(implementation)
+    {
+#ifdef QMPU6050_DECODER_X86
+    case QMPU6050Decoder::AVX2Implementation:
+        decodeAVX2<PacketSize>(packets, count, lanes, output);
+        return;
+    case QMPU6050Decoder::SSSE3Implementation:
+        decodeSSSE3<PacketSize>(packets, count, lanes, output);
+        return;
+#endif
+#ifdef QMPU6050_DECODER_NEON
+    case QMPU6050Decoder::NEONImplementation:
+        decodeNEON<PacketSize>(packets, count, lanes, output);
+        return;
+#endif
+    default:
+        decodeScalar<PacketSize>(packets, 0, count, lanes, output);
+        return;
+    }
+}
+
+QMPU6050Decoder::Implementation bestImplementation()
+{
+#ifdef QMPU6050_DECODER_X86
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx2"))
+        return QMPU6050Decoder::AVX2Implementation;
+
+    if(__builtin_cpu_supports("ssse3"))
+        return QMPU6050Decoder::SSSE3Implementation;
+#endif
+#ifdef QMPU6050_DECODER_NEON
+    return QMPU6050Decoder::NEONImplementation;
+#endif
+
+    return QMPU6050Decoder::ScalarImplementation;
+}
+
+//conversion factors for every AFS_SEL/FS_SEL pair, indexed by AFS_SEL << 2 | FS_SEL
+template<QMPU6050Decoder::Scale (*Make)(quint8, quint8)>
+constexpr std::array<QMPU6050Decoder::Scale, 16> scaleTable()
+{
+    std::array<QMPU6050Decoder::Scale, 16> table;
+
+    for(int i = 0; i < 16; ++i)
+        table[i] = Make(static_cast<quint8>(i >> 2), static_cast<quint8>(i & 0x03));
+
+    return table;
+}
+
+constexpr std::array<QMPU6050Decoder::Scale, 16> nativeScales = scaleTable<QMPU6050Decoder::Scale::native>();
+constexpr std::array<QMPU6050Decoder::Scale, 16> siScales = scaleTable<QMPU6050Decoder::Scale::si>();
+
+static_assert(nativeScales[0].acceleration == 1.0f / 16384 && nativeScales[15].rotation == 1.0f / 16.4f);
+
+//-1 until the first decode picked the best kernel
+QAtomicInteger<int> selected = -1;
+
+}
+
+/*!
+ * Returns the g and degrees/s factors for AFS_SEL \a accelRange and FS_SEL
+ * \a gyroRange. The pointer stays valid forever.
+ */
+const QMPU6050Decoder::Scale *QMPU6050Decoder::nativeScale(quint8 accelRange, quint8 gyroRange)
+{
+    return &nativeScales[((accelRange & 0x03) << 2) | (gyroRange & 0x03)];
+}
+
+/*!
+ * Returns the m/s^2 and rad/s factors for AFS_SEL \a accelRange and FS_SEL
+ * \a gyroRange. The pointer stays valid forever.
+ */
+const QMPU6050Decoder::Scale *QMPU6050Decoder::siScale(quint8 accelRange, quint8 gyroRange)
+{
+    return &siScales[((accelRange & 0x03) << 2) | (gyroRange & 0x03)];
+}
+
+/*!
+ * Returns the AFS_SEL a pointer from nativeScale() or siScale() was made
+ * for, 0 for any other scale.
+ */
+quint8 QMPU6050Decoder::accelerationRange(const Scale *scale)
+{
+    if(scale >= nativeScales.data() && scale < nativeScales.data() + 16)
+        return static_cast<quint8>((scale - nativeScales.data()) >> 2);
+
+    if(scale >= siScales.data() && scale < siScales.data() + 16)
+        return static_cast<quint8>((scale - siScales.data()) >> 2);
+
+    return 0;
+}
+
+/*!
+ * Returns the FS_SEL a pointer from nativeScale() or siScale() was made
+ * for, 0 for any other scale.
+ */
+quint8 QMPU6050Decoder::rotationRange(const Scale *scale)
+{
+    if(scale >= nativeScales.data() && scale < nativeScales.data() + 16)
+        return static_cast<quint8>((scale - nativeScales.data()) & 0x03);
+
+    if(scale >= siScales.data() && scale < siScales.data() + 16)
+        return static_cast<quint8>((scale - siScales.data()) & 0x03);
+
+    return 0;
+}
+
+/*!
+ * Returns whether packets of \a packetSize bytes can be block decoded.
+ */
+bool QMPU6050Decoder::isSupported(quint16 packetSize)
+{
+    return packetSize == 12 || packetSize == 14;
+}
+
+/*!
+ * Decodes \a count packets of \a packetSize bytes into \a output, entry i of
+ * each channel array coming from packet i.
+ */
+void QMPU6050Decoder::decode(const quint8 *packets, qsizetype count, quint16 packetSize, const Scale &scale, Output *output)
+{
+    if(count <= 0)
+        return;
+
+    if(packetSize == 14)
+        decodeWith<14>(implementation(), packets, count, scale, output);
+    else if(packetSize == 12)
+        decodeWith<12>(implementation(), packets, count, scale, output);
+}
+
+/*!
+ * Returns the kernel in use.
+ */
+QMPU6050Decoder::Implementation QMPU6050Decoder::implementation()
+{
+    int current = selected.loadRelaxed();
+
+    if(Q_UNLIKELY(current < 0))
+    {
+        current = bestImplementation();
+        selected.storeRelaxed(current);
+    }
+
+    return static_cast<Implementation>(current);
+}
+
+/*!
+ * Forces a kernel, e.g. the scalar one to compare against. Returns false if
+ * it is not available on this CPU.
+ */
+bool QMPU6050Decoder::setImplementation(Implementation implementation)
+{
+    if(!isAvailable(implementation))
+        return false;
+
+    selected.storeRelaxed(implementation);
+
+    return true;
+}
+
+bool QMPU6050Decoder::isAvailable(Implementation implementation)
+{
+    switch(implementation)
+    {
+    case ScalarImplementation:
+        return true;
+#ifdef QMPU6050_DECODER_X86
+    case SSSE3Implementation:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3");
+    case AVX2Implementation:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+#ifdef QMPU6050_DECODER_NEON
+    case NEONImplementation:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
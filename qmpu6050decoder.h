@@ -0,0 +1,105 @@
+#ifndef QMPU6050DECODER_H
+#define QMPU6050DECODER_H
+
+#include <QtCore/qglobal.h>
+#include "qmpu6050_global.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Block decoder for FIFO packets
+ *
+ * Converts a run of interleaved big-endian packets, 12 byte accel + gyro or
+ * 14 byte accel + temp + gyro, into one array per channel in a single pass:
+ * every packet is byte-swapped, sign-extended, converted and scaled as one
+ * vector. The kernel is picked once at runtime from what the CPU supports,
+ * AVX2 or SSSE3 on x86 and NEON on ARM, with a portable scalar kernel as
+ * fallback.
+ *
+ * Packets holding other channel combinations are left to
+ * QMPU6050Acquisition::decode().
+ *
+ * The conversion factors for every AFS_SEL/FS_SEL combination are computed
+ * at compile time. nativeScale() and siScale() hand out pointers into those
+ * tables, so a range change is a pointer swap and converting a channel stays
+ * a single multiply.
+ */
+class QMPU6_5__EXPORT QMPU6050Decoder
+{
+public:
+    enum Implementation
+    {
+        ScalarImplementation,
+        SSSE3Implementation,
+        AVX2Implementation,
+        NEONImplementation
+    };
+
+    enum Channel
+    {
+        AccelerationX = 0,
+        AccelerationY,
+        AccelerationZ,
+        Temperature,
+        RotationX,
+        RotationY,
+        RotationZ,
+        ChannelCount
+    };
+
+    //sensitivity in LSB/g indexed by AFS_SEL and in LSB/(degrees/s) by FS_SEL
+    static constexpr float accelerationSensitivity[4] = { 16384, 8192, 4096, 2048 };
+    static constexpr float rotationSensitivity[4] = { 131, 65.5f, 32.8f, 16.4f };
+
+    //value = raw * factor (+ temperatureOffset for the temperature)
+    struct Scale
+    {
+        float acceleration = 1.0f / 16384;
+        float temperature = 1.0f / 340;
+        float temperatureOffset = 36.53f;
+        float rotation = 1.0f / 131;
+
+        //g, degrees C and degrees/s for AFS_SEL \a accelRange and FS_SEL \a gyroRange
+        static constexpr Scale native(quint8 accelRange = 0, quint8 gyroRange = 0)
+        {
+            Scale scale;
+            scale.acceleration = 1.0f / accelerationSensitivity[accelRange & 0x03];
+            scale.rotation = 1.0f / rotationSensitivity[gyroRange & 0x03];
+            return scale;
+        }
+
+        //m/s^2, degrees C and rad/s
+        static constexpr Scale si(quint8 accelRange = 0, quint8 gyroRange = 0)
+        {
+            Scale scale;
+            scale.acceleration = 9.80665f / accelerationSensitivity[accelRange & 0x03];
+            scale.rotation = 3.14159265358979f / 180 / rotationSensitivity[gyroRange & 0x03];
+            return scale;
+        }
+    };
+
+    //one array per channel with room for every packet, entries for channels
+    //missing from the packets are left alone; the raw arrays are optional,
+    //set all of them or none
+    struct Output
+    {
+        float *values[ChannelCount] = {};
+        qint16 *raw[ChannelCount] = {};
+    };
+
+    static const Scale *nativeScale(quint8 accelRange, quint8 gyroRange);
+    static const Scale *siScale(quint8 accelRange, quint8 gyroRange);
+    static quint8 accelerationRange(const Scale *scale);
+    static quint8 rotationRange(const Scale *scale);
+
+    static bool isSupported(quint16 packetSize);
+    static void decode(const quint8 *packets, qsizetype count, quint16 packetSize, const Scale &scale, Output *output);
+
+    static Implementation implementation();
+    static bool setImplementation(Implementation implementation);
+    static bool isAvailable(Implementation implementation);
+};
+
+QT_END_NAMESPACE
+
+#endif // QMPU6050DECODER_H
@@ -0,0 +1,409 @@
+#include "qmpu6050emulator.h"
+#include "qmpu6050_p.h"
+
+#include <cmath>
+#include <cstring>
+
+QMPU6050Emulator::QMPU6050Emulator(quint16 address)
+{
+    m_address = address;
+    m_epoch = timestamp();
+
+    reset();
+}
+
+bool QMPU6050Emulator::open()
+{
+    m_open = true;
+    return true;
+}
+
+bool QMPU6050Emulator::close()
+{
+    m_open = false;
+    return true;
+}
+
+bool QMPU6050Emulator::isOpen() const
+{
+    return m_open;
+}
+
+bool QMPU6050Emulator::bind(quint16 address)
+{
+    Q_UNUSED(address)
+    return true;
+}
+
+/*!
+ * Executes \a messages against the register file. A message addressed to
+ * anything but address() fails with ENXIO, the way an unacknowledged address
+ * does on a real adapter.
+ */
+bool QMPU6050Emulator::transfer(struct i2c_msg *messages, quint32 count)
+{
+    if(!m_open)
+    {
+        errno = EBADF;
+        return false;
+    }
+
+    for(quint32 i = 0; i < count; ++i)
+    {
+        if(messages[i].addr != m_address)
+        {
+            errno = ENXIO;
+            return false;
+        }
+    }
+
+    ++m_transferCount;
+
+    advance();
+
+    for(quint32 i = 0; i < count; ++i)
+    {
+        struct i2c_msg &message = messages[i];
+
+        if(message.flags & I2C_M_RD)
+        {
+            for(quint16 j = 0; j < message.len; ++j)
+            {
+                message.buf[j] = readRegister(m_pointer);
+
+                if(m_pointer != MPU6050_RA_FIFO_R_W && m_pointer != MPU6050_RA_MEM_R_W)
+                    ++m_pointer;
+            }
+        }
+        else if(message.len > 0)
+        {
+            m_pointer = message.buf[0];
+
+            for(quint16 j = 1; j < message.len; ++j)
+            {
+                writeRegister(m_pointer, message.buf[j]);
+
+                if(m_pointer != MPU6050_RA_FIFO_R_W && m_pointer != MPU6050_RA_MEM_R_W)
+                    ++m_pointer;
+            }
+        }
+    }
+
+    return true;
+}
+
+quint16 QMPU6050Emulator::address() const
+{
+    return m_address;
+}
+
+/*!
+ * Sets the linear vibration to \a amplitude g at \a frequency Hz, on top of
+ * 1 g of gravity along Z.
+ */
+void QMPU6050Emulator::setVibration(qreal frequency, qreal amplitude)
+{
+    m_vibrationFrequency = frequency;
+    m_vibrationAmplitude = amplitude;
+}
+
+/*!
+ * Sets the angular oscillation to \a amplitude deg/s at \a frequency Hz.
+ */
+void QMPU6050Emulator::setRotation(qreal frequency, qreal amplitude)
+{
+    m_rotationFrequency = frequency;
+    m_rotationAmplitude = amplitude;
+}
+
+/*!
+ * Sets the peak white noise added to every raw sample, in LSB.
+ */
+void QMPU6050Emulator::setNoise(qint16 amplitude)
+{
+    m_noise = amplitude;
+}
+
+quint64 QMPU6050Emulator::sampleCount() const
+{
+    return m_sampleCount;
+}
+
+quint64 QMPU6050Emulator::transferCount() const
+{
+    return m_transferCount;
+}
+
+/*!
+ * Serves every bus acquired afterwards whose path starts with \a prefix with
+ * its own emulator.
+ */
+void QMPU6050Emulator::registerTransport(const QString &prefix)
+{
+    QI2CTransport::registerFactory(prefix, [](const QString &path) -> QI2CTransport*
+    {
+        Q_UNUSED(path)
+        return new QMPU6050Emulator;
+    });
+}
+
+/*!
+ * Restores the power-on register state. The chip comes up asleep with only
+ * PWR_MGMT_1 and WHO_AM_I non-zero.
+ */
+void QMPU6050Emulator::reset()
+{
+    memset(m_registers, 0, sizeof(m_registers));
+    memset(m_memory, 0, sizeof(m_memory));
+
+    m_registers[MPU6050_RA_PWR_MGMT_1] = (1 << MPU6050_PWR1_SLEEP_BIT);
+    m_registers[MPU6050_RA_WHO_AM_I] = MPU6050_ADDRESS_AD0_LOW;
+
+    m_fifoHead = 0;
+    m_fifoCount = 0;
+    m_nextSample = 0;
+}
+
+/*!
+ * Runs the sample clock up to the current time. After a long pause only the
+ * samples that can still show up in the FIFO are generated.
+ */
+void QMPU6050Emulator::advance()
+{
+    if(m_registers[MPU6050_RA_PWR_MGMT_1] & (1 << MPU6050_PWR1_SLEEP_BIT))
+    {
+        m_nextSample = 0;
+        return;
+    }
+
+    quint64 current = timestamp();
+    quint64 period = samplePeriod();
+
+    if(!m_nextSample)
+    {
+        m_nextSample = current + period;
+        return;
+    }
+
+    if(current < m_nextSample)
+        return;
+
+    quint64 due = (current - m_nextSample) / period + 1;
+
+    if(due > fifoSize)
+    {
+        m_nextSample += (due - fifoSize) * period;
+        due = fifoSize;
+    }
+
+    for(; due > 0; --due)
+    {
+        sample(m_nextSample);
+        m_nextSample += period;
+    }
+}
+
+/*!
+ * Latches the synthetic motion at monotonic \a time into the data registers
+ * and the FIFO.
+ */
+void QMPU6050Emulator::sample(quint64 time)
+{
+    const qreal t = (time - m_epoch) / 1e9;
+    const qreal vibration = 2 * M_PI * m_vibrationFrequency * t;
+    const qreal rotation = 2 * M_PI * m_rotationFrequency * t;
+
+    const qreal accelScale = 16384 >> ((m_registers[MPU6050_RA_ACCEL_CONFIG] >> 3) & 0x03);
+    const qreal gyroScale = 131.0 / (1 << ((m_registers[MPU6050_RA_GYRO_CONFIG] >> 3) & 0x03));
+
+    qreal values[7] =
+    {
+        m_vibrationAmplitude * sin(vibration) * accelScale,
+        m_vibrationAmplitude * 0.5 * cos(vibration) * accelScale,
+        (1 + m_vibrationAmplitude * 0.25 * sin(2 * vibration)) * accelScale,
+        ((25 + 0.5 * sin(t / 60)) - 36.53) * 340,
+        m_rotationAmplitude * sin(rotation) * gyroScale,
+        m_rotationAmplitude * cos(rotation) * gyroScale,
+        m_rotationAmplitude * 0.5 * sin(rotation / 2) * gyroScale
+    };
+
+    quint8 *data = m_registers + MPU6050_RA_ACCEL_XOUT_H;
+
+    for(int i = 0; i < 7; ++i)
+    {
+        qreal value = values[i] + (i == 3 ? 0 : noise());
+        qint16 raw = (qint16)qBound<qreal>(-32768, value, 32767);
+
+        data[i * 2] = (quint8)(raw >> 8);
+        data[i * 2 + 1] = (quint8)raw;
+    }
+
+    m_registers[MPU6050_RA_INT_STATUS] |= (1 << MPU6050_INTERRUPT_DATA_RDY_BIT);
+    ++m_sampleCount;
+
+    if(!(m_registers[MPU6050_RA_USER_CTRL] & (1 << MPU6050_USERCTRL_FIFO_EN_BIT)))
+        return;
+
+    //packet order is fixed by the register map, not by the enable bits
+    quint8 enabled = m_registers[MPU6050_RA_FIFO_EN];
+
+    if(enabled & (1 << MPU6050_ACCEL_FIFO_EN_BIT))
+        pushFIFO(data, 6);
+    if(enabled & (1 << MPU6050_TEMP_FIFO_EN_BIT))
+        pushFIFO(data + 6, 2);
+    if(enabled & (1 << MPU6050_XG_FIFO_EN_BIT))
+        pushFIFO(data + 8, 2);
+    if(enabled & (1 << MPU6050_YG_FIFO_EN_BIT))
+        pushFIFO(data + 10, 2);
+    if(enabled & (1 << MPU6050_ZG_FIFO_EN_BIT))
+        pushFIFO(data + 12, 2);
+}
+
+quint8 QMPU6050Emulator::readRegister(quint8 reg)
+{
+    quint8 value = 0;
+
+    switch(reg)
+    {
+    case MPU6050_RA_FIFO_COUNTH:
+        value = (quint8)(m_fifoCount >> 8);
+        break;
+    case MPU6050_RA_FIFO_COUNTL:
+        value = (quint8)m_fifoCount;
+        break;
+    case MPU6050_RA_FIFO_R_W:
+        if(m_fifoCount)
+        {
+            value = m_fifo[m_fifoHead];
+            m_fifoHead = (m_fifoHead + 1) % fifoSize;
+            --m_fifoCount;
+        }
+        break;
+    case MPU6050_RA_MEM_R_W:
+    {
+        quint8 bank = m_registers[MPU6050_RA_BANK_SEL] % memoryBankCount;
+        value = m_memory[bank * memoryBankSize + m_registers[MPU6050_RA_MEM_START_ADDR]++];
+        break;
+    }
+    case MPU6050_RA_INT_STATUS:
+        value = m_registers[reg];
+        m_registers[reg] = 0;
+        break;
+    default:
+        value = m_registers[reg];
+        break;
+    }
+
+    //INT_RD_CLEAR clears the status on any read
+    if(m_registers[MPU6050_RA_INT_PIN_CFG] & (1 << MPU6050_INTCFG_INT_RD_CLEAR_BIT))
+        m_registers[MPU6050_RA_INT_STATUS] = 0;
+
+    return value;
+}
+
+void QMPU6050Emulator::writeRegister(quint8 reg, quint8 value)
+{
+    switch(reg)
+    {
+    //read-only status and data registers
+    case MPU6050_RA_I2C_MST_STATUS:
+    case MPU6050_RA_DMP_INT_STATUS:
+    case MPU6050_RA_INT_STATUS:
+    case MPU6050_RA_MOT_DETECT_STATUS:
+    case MPU6050_RA_FIFO_COUNTH:
+    case MPU6050_RA_FIFO_COUNTL:
+    case MPU6050_RA_WHO_AM_I:
+        break;
+    case MPU6050_RA_FIFO_R_W:
+        pushFIFO(&value, 1);
+        break;
+    case MPU6050_RA_MEM_R_W:
+    {
+        quint8 bank = m_registers[MPU6050_RA_BANK_SEL] % memoryBankCount;
+        m_memory[bank * memoryBankSize + m_registers[MPU6050_RA_MEM_START_ADDR]++] = value;
+        break;
+    }
+    case MPU6050_RA_SIGNAL_PATH_RESET:
+        memset(m_registers + MPU6050_RA_ACCEL_XOUT_H, 0, MPU6050_RA_GYRO_ZOUT_L - MPU6050_RA_ACCEL_XOUT_H + 1);
+        break;
+    case MPU6050_RA_USER_CTRL:
+        if(value & (1 << MPU6050_USERCTRL_FIFO_RESET_BIT))
+        {
+            m_fifoHead = 0;
+            m_fifoCount = 0;
+        }
+
+        //the low four bits are resets and clear themselves
+        m_registers[reg] = value & 0xF0;
+        break;
+    case MPU6050_RA_PWR_MGMT_1:
+        if(value & (1 << MPU6050_PWR1_DEVICE_RESET_BIT))
+        {
+            reset();
+            break;
+        }
+
+        m_registers[reg] = value;
+        break;
+    case MPU6050_RA_SMPLRT_DIV:
+    case MPU6050_RA_CONFIG:
+        //restart the sample clock at the new rate
+        m_registers[reg] = value;
+        m_nextSample = 0;
+        advance();
+        break;
+    default:
+        if(reg >= MPU6050_RA_ACCEL_XOUT_H && reg <= MPU6050_RA_EXT_SENS_DATA_23)
+            break;
+
+        m_registers[reg] = value;
+        break;
+    }
+}
+
+/*!
+ * Appends \a length bytes to the FIFO. On overflow the oldest bytes are
+ * dropped and FIFO_OFLOW is raised, as on the chip.
+ */
+void QMPU6050Emulator::pushFIFO(const quint8 *data, int length)
+{
+    for(int i = 0; i < length; ++i)
+    {
+        if(m_fifoCount == fifoSize)
+        {
+            m_fifoHead = (m_fifoHead + 1) % fifoSize;
+            --m_fifoCount;
+
+            m_registers[MPU6050_RA_INT_STATUS] |= (1 << MPU6050_INTERRUPT_FIFO_OFLOW_BIT);
+        }
+
+        m_fifo[(m_fifoHead + m_fifoCount) % fifoSize] = data[i];
+        ++m_fifoCount;
+    }
+}
+
+/*!
+ * Returns the sample period in ns: the gyroscope output rate, 8 kHz with the
+ * DLPF disabled and 1 kHz otherwise, divided by 1 + SMPLRT_DIV.
+ */
+quint64 QMPU6050Emulator::samplePeriod() const
+{
+    quint8 dlpf = m_registers[MPU6050_RA_CONFIG] & 0x07;
+    quint64 outputPeriod = (dlpf == 0 || dlpf == 7) ? 125000 : 1000000;
+
+    return outputPeriod * (1 + m_registers[MPU6050_RA_SMPLRT_DIV]);
+}
+
+/*!
+ * Returns uniform noise within +-m_noise from a fixed-seed LCG, so runs are
+ * reproducible.
+ */
+qint16 QMPU6050Emulator::noise()
+{
+    if(m_noise <= 0)
+        return 0;
+
+    m_seed = m_seed * 1664525u + 1013904223u;
+
+    return (qint16)((qint32)(m_seed >> 16) % (2 * m_noise + 1) - m_noise);
+}
@@ -0,0 +1,108 @@
+#ifndef QMPU6050EMULATOR_H
+#define QMPU6050EMULATOR_H
+
+#include <QObject>
+#include "qmpu6050_global.h"
+#include "qi2ctransport.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief In-process MPU6050 behind the QI2CTransport interface
+ *
+ * Emulates the register file of a single MPU6050 so the complete stack,
+ * backends and acquisition engine included, runs without hardware. Buses
+ * whose path starts with the prefix given to registerTransport() (by default
+ * "emulator:") are served by a fresh emulator, e.g.
+ *
+ * \code
+ * QMPU6050Emulator::registerTransport();
+ * sensor->setProperty("i2c-bus", "emulator:mpu6050");
+ * \endcode
+ *
+ * Emulated behaviour:
+ *  - WHO_AM_I, register pointer auto-increment and power-on defaults,
+ *    including DEVICE_RESET and the self-clearing reset bits
+ *  - a sample clock at the gyroscope output rate (8 kHz with the DLPF off,
+ *    1 kHz otherwise) divided by 1 + SMPLRT_DIV, running while not asleep
+ *  - accelerometer, temperature and gyroscope data from a synthetic motion
+ *    generator, scaled by AFS_SEL and FS_SEL
+ *  - the 1024 byte FIFO filled per FIFO_EN, with FIFO_COUNT, FIFO_R_W,
+ *    FIFO_RESET and overflow dropping the oldest bytes
+ *  - INT_STATUS with DATA_RDY and FIFO_OFLOW, cleared on read
+ *  - DMP memory banks through BANK_SEL, MEM_START_ADDR and MEM_R_W
+ *
+ * The auxiliary I2C master and the DMP firmware itself are not emulated.
+ * Like every transport it is only called with the bus mutex held; take
+ * QI2CBus::mutex() before calling the setters on a live emulator.
+ */
+class QMPU6_5__EXPORT QMPU6050Emulator : public QI2CTransport
+{
+    Q_DISABLE_COPY(QMPU6050Emulator)
+public:
+    static constexpr int memoryBankCount = 8;
+    static constexpr int memoryBankSize = 256;
+    static constexpr int fifoSize = 1024;
+
+    explicit QMPU6050Emulator(quint16 address = 0x68);
+
+    virtual bool open() override;
+    virtual bool close() override;
+    virtual bool isOpen() const override;
+
+    virtual bool bind(quint16 address) override;
+    virtual bool transfer(struct i2c_msg *messages, quint32 count) override;
+
+    quint16 address() const;
+
+    void setVibration(qreal frequency, qreal amplitude);
+    void setRotation(qreal frequency, qreal amplitude);
+    void setNoise(qint16 amplitude);
+
+    quint64 sampleCount() const;
+    quint64 transferCount() const;
+
+    static void registerTransport(const QString &prefix = QStringLiteral("emulator:"));
+
+private:
+    void reset();
+    void advance();
+    void sample(quint64 time);
+
+    quint8 readRegister(quint8 reg);
+    void writeRegister(quint8 reg, quint8 value);
+    void pushFIFO(const quint8 *data, int length);
+
+    quint64 samplePeriod() const;
+    qint16 noise();
+
+    quint16 m_address = 0x68;
+    bool m_open = false;
+
+    quint8 m_pointer = 0;
+    quint8 m_registers[256];
+    quint8 m_memory[memoryBankCount * memoryBankSize];
+
+    //circular FIFO storage
+    quint8 m_fifo[fifoSize];
+    quint16 m_fifoHead = 0;
+    quint16 m_fifoCount = 0;
+
+    //monotonic time in ns, 0 while the sample clock is stopped
+    quint64 m_nextSample = 0;
+    quint64 m_epoch = 0;
+
+    //motion generator, frequencies in Hz, amplitudes in g and deg/s
+    qreal m_vibrationFrequency = 5;
+    qreal m_vibrationAmplitude = 0.05;
+    qreal m_rotationFrequency = 0.5;
+    qreal m_rotationAmplitude = 30;
+    qint16 m_noise = 4;
+    quint32 m_seed = 1;
+
+    quint64 m_sampleCount = 0;
+    quint64 m_transferCount = 0;
+};
+
+QT_END_NAMESPACE
+#endif // QMPU6050EMULATOR_H
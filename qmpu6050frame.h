@@ -0,0 +1,87 @@
+#ifndef QMPU6_5_FRAME_H
+#define QMPU6_5_FRAME_H
+
+#include <QtCore/qglobal.h>
+#include <QMetaType>
+#include "qmpu6050_global.h"
+#include "qbroadcastring.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Decoded ACCEL_XOUT_H..GYRO_ZOUT_L burst
+ *
+ * One frame holds every channel sampled by the chip at the same instant.
+ * Raw values are the 16-bit two's complement register contents, scaled
+ * values are in g, degrees C and degrees/s. Scaled values are only filled
+ * in while a listener asks for QMPU6050Acquisition::FloatingPointOutput.
+ */
+struct QMPU6050Frame
+{
+    quint64 timestamp = 0; //microseconds, CLOCK_MONOTONIC
+    quint32 gap = 0;       //samples lost right before this one
+
+    qint16 rawAcceleration[3] = { 0, 0, 0 };
+    qint16 rawTemperature = 0;
+    qint16 rawRotation[3] = { 0, 0, 0 };
+
+    //AFS_SEL and FS_SEL the sample was taken with
+    quint8 accelerationRange = 0;
+    quint8 rotationRange = 0;
+
+    qreal acceleration[3] = { 0, 0, 0 };
+    qreal temperature = 0;
+    qreal rotation[3] = { 0, 0, 0 };
+};
+
+/*!
+ * \brief Integer-only frame for consumers without floating point
+ *
+ * Carries the register contents in LSB together with the full scale ranges
+ * they were sampled with, a quarter of the payload of the scaled values in
+ * QMPU6050Frame. The Q16 accessors convert to Q16.16 fixed point in g,
+ * degrees C and degrees/s with one 64-bit multiply and shift per value.
+ */
+struct QMPU6050FixedFrame
+{
+    //Q16.16 per LSB, 2^32 / sensitivity, indexed by AFS_SEL and FS_SEL
+    static constexpr qint32 q16AccelerationFactor[4] = { 262144, 524288, 1048576, 2097152 };
+    static constexpr qint32 q16RotationFactor[4] = { 32786010, 65572020, 130944125, 261888250 };
+    static constexpr qint32 q16TemperatureFactor = 12632257; //2^32 / 340
+    static constexpr qint32 q16TemperatureOffset = 2394030;  //36.53 * 2^16
+
+    quint64 timestamp = 0; //microseconds, CLOCK_MONOTONIC
+    quint32 gap = 0;       //samples lost right before this one
+
+    qint16 acceleration[3] = { 0, 0, 0 };
+    qint16 temperature = 0;
+    qint16 rotation[3] = { 0, 0, 0 };
+
+    quint8 accelerationRange = 0;
+    quint8 rotationRange = 0;
+
+    qint32 accelerationQ16(int axis) const
+    {
+        return static_cast<qint32>((static_cast<qint64>(acceleration[axis]) * q16AccelerationFactor[accelerationRange & 0x03]) >> 16);
+    }
+
+    qint32 temperatureQ16() const
+    {
+        return static_cast<qint32>((static_cast<qint64>(temperature) * q16TemperatureFactor) >> 16) + q16TemperatureOffset;
+    }
+
+    qint32 rotationQ16(int axis) const
+    {
+        return static_cast<qint32>((static_cast<qint64>(rotation[axis]) * q16RotationFactor[rotationRange & 0x03]) >> 16);
+    }
+};
+
+//full-rate frame stream shared by any number of readers
+typedef QBroadcastRing<QMPU6050Frame, 2048> QMPU6050FrameRing;
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(QMPU6050Frame)
+Q_DECLARE_METATYPE(QMPU6050FixedFrame)
+
+#endif // QMPU6_5_FRAME_H
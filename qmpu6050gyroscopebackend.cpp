@@ -1,11 +1,10 @@
 #include "qmpu6050gyroscopebackend.h"
 
+#include <string.h>
+
 QMPU6050GyroscopeBackend::QMPU6050GyroscopeBackend(QSensor *sensor)
     : QSensorBackend{sensor}
 {
-    m_pollTimer = new QTimer(this);
-    QObject::connect(m_pollTimer, SIGNAL(timeout()), this, SLOT(poll()));
-
     QGyroscope *child = qobject_cast<QGyroscope*>(sensor);
 
     if(child)
@@ -14,29 +13,38 @@ QMPU6050GyroscopeBackend::QMPU6050GyroscopeBackend(QSensor *sensor)
         setReading<QGyroscopeReading>(&m_reading);
         reading();
 
-        //setup i2c device
-        m_i2c = new QI2CDevice;
+        //attach to the shared acquisition engine of the chip
+        QString bus = "/dev/i2c-1";
+        quint8 address = 0x68;
 
         if(child->property("i2c-bus").isValid())
-            m_i2c->setBus(child->property("i2c-bus").toString());
-        else
-            m_i2c->setBus("/dev/i2c-1");
+            bus = child->property("i2c-bus").toString();
 
         if(child->property("i2c-address").isValid())
-            m_i2c->setAddress(static_cast<quint8>(child->property("i2c-address").toUInt()));
+            address = static_cast<quint8>(child->property("i2c-address").toUInt());
+
+        //stream from the chip FIFO instead of polling the data registers
+        if(child->property("fifo-streaming").isValid())
+            m_fifoStreaming = child->property("fifo-streaming").toBool();
+
+        if(m_fifoStreaming)
+            addDataRate(1, 8000);
         else
-            m_i2c->setAddress(static_cast<quint8>(0x68));
+            addDataRate(1, QMPU6050Acquisition::maximumRate(QMPU6050Acquisition::PollingMode, QMPU6050Acquisition::Gyroscope));
+
+        m_acquisition = QMPU6050Acquisition::acquire(bus, address);
+        m_acquisition->configure(child);
+        QObject::connect(m_acquisition, &QMPU6050Acquisition::errorOccurred, this, &QMPU6050GyroscopeBackend::handleError);
     }
 }
 
 QMPU6050GyroscopeBackend::~QMPU6050GyroscopeBackend()
 {
-    if(m_pollTimer)
+    if(m_acquisition)
     {
-        if(m_pollTimer->isActive())
-            m_pollTimer->stop();
-
-        delete m_pollTimer;
+        m_acquisition->detach(this);
+        QObject::disconnect(m_acquisition, nullptr, this, nullptr);
+        QMPU6050Acquisition::release(m_acquisition);
     }
 
     QSensorBackend::~QSensorBackend();
@@ -44,93 +52,63 @@ QMPU6050GyroscopeBackend::~QMPU6050GyroscopeBackend()
 
 void QMPU6050GyroscopeBackend::start()
 {
-    if(m_pollTimer && m_pollTimer->isActive())
+    if(!m_acquisition || m_acquisition->isAttached(this))
         return;
 
-    m_pollTimer->setInterval(1000 / sensor()->dataRate());
-    m_pollTimer->start();
+    m_acquisition->attach(this, sensor()->dataRate(), QMPU6050Acquisition::Gyroscope, m_fifoStreaming ? QMPU6050Acquisition::FIFOMode : QMPU6050Acquisition::PollingMode);
 }
 
 void QMPU6050GyroscopeBackend::stop()
 {
-    if(!m_pollTimer || !m_pollTimer->isActive())
+    if(!m_acquisition || !m_acquisition->isAttached(this))
         return;
 
-    m_pollTimer->stop();
+    m_acquisition->detach(this);
 }
 
-void QMPU6050GyroscopeBackend::poll()
+void QMPU6050GyroscopeBackend::frameReceived(const QMPU6050Frame &frame)
 {
-    if(!m_i2c->start())
-    {
-        reportError("COULD NOT START I2C");
-        handleFault();
-        return;
-    }
-
-    quint8 *buffer = new quint8[6];
-
-    if(!m_i2c->read(static_cast<quint8>(MPU6050_RA_GYRO_XOUT_H), buffer, 6))
-    {
-        m_i2c->end();
-        delete [] buffer;
-        handleFault();
-        return;
-    }
-
-    qreal x = ((((qint16)buffer[0]) << 8) | buffer[1]);
-    qreal y = ((((qint16)buffer[2]) << 8) | buffer[3]);
-    qreal z = ((((qint16)buffer[4]) << 8) | buffer[5]);
-
-    if(x > 32768)
-        x = (x - 65536) / 131.0;
-    else
-        x /= 131.0;
-
-    if(y > 32768)
-        y = (y - 65536) / 131.0;
-    else
-        y /= 131.0;
-
-    if(z > 32768)
-        z = (z - 65536) / 131.0;
-    else
-        z /= 131.0;
-
-    delete [] buffer;
-
-    if(!m_i2c->end())
-        handleFault();
-
-    m_reading.setX(x);
-    m_reading.setY(y);
-    m_reading.setZ(z);
+    m_reading.setTimestamp(frame.timestamp);
+    m_reading.setX(frame.rotation[0]);
+    m_reading.setY(frame.rotation[1]);
+    m_reading.setZ(frame.rotation[2]);
 
     newReadingAvailable();
 }
 
+/*!
+ * Hands a failed register access to the acquisition engine, which checks
+ * and if needed recovers the chip on its own thread before the next cycle.
+ */
 void QMPU6050GyroscopeBackend::handleFault()
 {
-    //TODO
+    if(m_acquisition)
+        m_acquisition->requestRecovery(errno);
+}
+
+/*!
+ * Reports an error the acquisition engine could not recover from.
+ */
+void QMPU6050GyroscopeBackend::handleError(int error)
+{
+    reportError(QString("ACQUISITION FAILED: %1").arg(strerror(error)));
+    sensorError(error);
 }
 
 void QMPU6050GyroscopeBackend::reportEvent(QString message)
 {
     //report event if backendDebug is true
     if(m_backendDebug)
-        qDebug() << QString("** %1 - (QMPU6050@%2:0x%3)").arg(message, m_i2c->bus()).arg(m_i2c->address(), 2, 16);
+        qDebug() << QString("** %1 - (QMPU6050@%2:0x%3)").arg(message, m_acquisition->bus()).arg(m_acquisition->address(), 2, 16);
 }
 
 void QMPU6050GyroscopeBackend::reportError(QString message)
 {
-    qDebug() << QString("!! ERROR: %1 - (QMPU6050@%2:0x%3)").arg(message, m_i2c->bus()).arg(m_i2c->address(), 2, 16);
+    qDebug() << QString("!! ERROR: %1 - (QMPU6050@%2:0x%3)").arg(message, m_acquisition->bus()).arg(m_acquisition->address(), 2, 16);
 }
 
 void QMPU6050GyroscopeBackend::onSensorDataRateChanged()
 {
-    if(m_pollTimer->isActive())
-    {
-        stop();
-        start();
-    }
+    if(m_acquisition && m_acquisition->isAttached(this))
+        m_acquisition->setRate(this, sensor()->dataRate());
 }
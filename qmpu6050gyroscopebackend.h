@@ -12,9 +12,10 @@
 #include <QObject>
 
 #include "qmpu6050backend.h"
+#include "qmpu6050acquisition.h"
 #include "qmpu6050_p.h"
 
-class QMPU6050GyroscopeBackend : public QSensorBackend
+class QMPU6050GyroscopeBackend : public QSensorBackend, public QMPU6050FrameListener
 {
     Q_OBJECT
 public:
@@ -27,19 +28,20 @@ public:
     virtual void start() override;
     virtual void stop() override;
 
+    virtual void frameReceived(const QMPU6050Frame &frame) override;
+
 private slots:
-    void poll();
     void handleFault();
+    void handleError(int error);
     void reportEvent(QString message);
     void reportError(QString message);
     void onSensorDataRateChanged();
 
 private:
-    QTimer *m_pollTimer = nullptr;
     QGyroscopeReading m_reading;
-    QI2CDevice *m_i2c = nullptr;
-
+    QMPU6050Acquisition *m_acquisition = nullptr;
     bool m_backendDebug = false;
+    bool m_fifoStreaming = false;
 };
 
 #endif // QMPU6_5_GYROSCOPEBACKEND_H
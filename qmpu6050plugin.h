@@ -13,6 +13,9 @@
 #include "qmpu6050accelerometerbackend.h"
 #include "qmpu6050gyroscopebackend.h"
 #include "qmpu6050.h"
+#include "qmpu6050emulator.h"
+#include "qi2crecordingtransport.h"
+#include "qi2creplaytransport.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -28,6 +31,12 @@ public:
         QSensorManager::registerBackend(QMPU6050::sensorType, QMPU6050Backend::id, this);
         QSensorManager::registerBackend(QAccelerometer::sensorType, QMPU6050AccelerometerBackend::id, this);
         QSensorManager::registerBackend(QGyroscope::sensorType, QMPU6050GyroscopeBackend::id, this);
+
+        //"emulator:" bus paths run against an in-process chip, "record:" and
+        //"replay:" capture and play back bus sessions
+        QMPU6050Emulator::registerTransport();
+        QI2CRecordingTransport::registerTransport();
+        QI2CReplayTransport::registerTransport();
     }
 
     void sensorsChanged() override
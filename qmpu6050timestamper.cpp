@@ -0,0 +1,150 @@
+#include "qmpu6050timestamper.h"
+
+#include <math.h>
+
+/*!
+ * Sets the sample period the chip was programmed for, in microseconds, and
+ * starts tracking from scratch.
+ */
+void QMPU6050Timestamper::setNominalPeriod(qreal period)
+{
+    m_nominalPeriod = period;
+    reset();
+}
+
+qreal QMPU6050Timestamper::nominalPeriod() const
+{
+    return m_nominalPeriod;
+}
+
+/*!
+ * Forgets the phase and the period estimate.
+ */
+void QMPU6050Timestamper::reset()
+{
+    m_period = m_nominalPeriod;
+    m_variance = 0;
+    m_locked = 0;
+}
+
+/*!
+ * Forgets the phase but keeps the period estimate, for when the sample
+ * sequence was interrupted, e.g. by a FIFO reset.
+ */
+void QMPU6050Timestamper::resync()
+{
+    if(m_locked)
+        ++m_resyncs;
+
+    m_locked = 0;
+}
+
+/*!
+ * Accounts for \a samples new samples, the newest of which was taken around
+ * \a observed and no later than \a limit.
+ */
+void QMPU6050Timestamper::update(quint32 samples, qreal observed, quint64 limit)
+{
+    if(!samples)
+        return;
+
+    qreal previous = m_last;
+
+    if(m_locked)
+    {
+        qreal predicted = m_last + samples * m_period;
+        qreal error = observed - predicted;
+
+        if(fabs(error) > resyncThreshold * m_nominalPeriod)
+        {
+            ++m_resyncs;
+            m_locked = 0;
+        }
+        else
+        {
+            //decaying gains average the first reads, the period gain is
+            //kept low until the phase settled
+            qreal alpha = qMax(minimumGain, 1.0 / (m_locked + 1));
+            qreal beta = qMin(alpha, 0.2) * qMin(alpha, 0.2) / (2 - qMin(alpha, 0.2));
+
+            m_last = predicted + alpha * error;
+            m_period = qBound(m_nominalPeriod * (1 - maximumDrift), m_period + beta * error / samples, m_nominalPeriod * (1 + maximumDrift));
+            m_variance += minimumGain * (error * error - m_variance);
+        }
+    }
+
+    if(!m_locked)
+        m_last = observed;
+
+    ++m_locked;
+    ++m_updates;
+    m_samples += samples;
+
+    //a sample can not be newer than the read that returned it
+    if(m_last > limit)
+        m_last = limit;
+
+    m_first = m_last - (samples - 1) * m_period;
+
+    //and must come after the ones already handed out
+    if(m_updates > 1 && m_first <= previous)
+    {
+        m_last = qMax(m_last, previous + 1);
+        m_first = qMin(previous + 1, m_last);
+    }
+
+    m_spacing = samples > 1 ? (m_last - m_first) / (samples - 1) : 0;
+}
+
+/*!
+ * Returns the time of sample \a index of the last update, 0 being the
+ * oldest.
+ */
+quint64 QMPU6050Timestamper::timestamp(quint32 index) const
+{
+    return static_cast<quint64>(llround(m_first + index * m_spacing));
+}
+
+/*!
+ * Returns the tracked sample period in microseconds.
+ */
+qreal QMPU6050Timestamper::period() const
+{
+    return m_period;
+}
+
+/*!
+ * Returns how far the chip's oscillator runs off CLOCK_MONOTONIC in parts
+ * per million, positive when it runs fast.
+ */
+qreal QMPU6050Timestamper::drift() const
+{
+    if(m_period <= 0)
+        return 0;
+
+    return (m_nominalPeriod / m_period - 1) * 1e6;
+}
+
+/*!
+ * Returns the RMS prediction error in microseconds, a measure of how noisy
+ * the read times are.
+ */
+qreal QMPU6050Timestamper::jitter() const
+{
+    return sqrt(m_variance);
+}
+
+quint64 QMPU6050Timestamper::sampleCount() const
+{
+    return m_samples;
+}
+
+quint64 QMPU6050Timestamper::updateCount() const
+{
+    return m_updates;
+}
+
+quint64 QMPU6050Timestamper::resyncCount() const
+{
+    return m_resyncs;
+}
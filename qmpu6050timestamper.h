@@ -0,0 +1,73 @@
+#ifndef QMPU6050TIMESTAMPER_H
+#define QMPU6050TIMESTAMPER_H
+
+#include <QtCore/qglobal.h>
+#include <QMetaType>
+#include "qmpu6050_global.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * \brief Reconstructs sample times from the chip's sample clock
+ *
+ * The MPU6050 samples on its internal oscillator, which is only specified to
+ * a few percent and drifts with temperature, so neither the nominal sample
+ * period nor the time a sample was read is a good sample time on its own.
+ *
+ * Every read hands the number of new samples and an estimate of when the
+ * newest of them was taken to update(). A second order tracking loop (an
+ * alpha-beta filter) predicts that time from the previous estimate and the
+ * tracked period, and corrects both by a fraction of the error. The gains
+ * start high so the loop locks within a few reads and settle at
+ * minimumGain, which averages out read latency over about fifty reads while
+ * still following thermal drift. Errors beyond resyncThreshold periods mean
+ * samples were lost or the chip restarted; the phase is then taken from the
+ * observation while the period estimate is kept.
+ *
+ * Times are microseconds on CLOCK_MONOTONIC. Samples are spaced evenly
+ * between reads, never come out later than the read that returned them and
+ * always increase.
+ */
+class QMPU6_5__EXPORT QMPU6050Timestamper
+{
+public:
+    static constexpr qreal minimumGain = 0.02;
+    static constexpr qreal maximumDrift = 0.1; //fraction of the nominal period
+    static constexpr qreal resyncThreshold = 8;
+
+    void setNominalPeriod(qreal period);
+    qreal nominalPeriod() const;
+
+    void reset();
+    void resync();
+
+    void update(quint32 samples, qreal observed, quint64 limit);
+    quint64 timestamp(quint32 index) const;
+
+    qreal period() const;
+    qreal drift() const;
+    qreal jitter() const;
+
+    quint64 sampleCount() const;
+    quint64 updateCount() const;
+    quint64 resyncCount() const;
+
+private:
+    qreal m_nominalPeriod = 0; //microseconds
+    qreal m_period = 0;
+    qreal m_last = 0;          //estimated time of the newest sample
+    qreal m_first = 0;         //time of the first sample of the last update
+    qreal m_spacing = 0;
+    qreal m_variance = 0;      //of the prediction error, microseconds squared
+
+    quint64 m_samples = 0;
+    quint64 m_updates = 0;
+    quint64 m_locked = 0;      //updates since the last (re)synchronization
+    quint64 m_resyncs = 0;
+};
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(QMPU6050Timestamper)
+
+#endif // QMPU6050TIMESTAMPER_H
@@ -0,0 +1,118 @@
+#ifndef QSPSCQUEUE_H
+#define QSPSCQUEUE_H
+
+#include <QtCore/qglobal.h>
+#include <QAtomicInteger>
+#include "qmpu6050_global.h"
+
+QT_BEGIN_NAMESPACE
+
+//assumed cache line size, producer and consumer state never share a line
+#define QSPSCQUEUE_CACHE_LINE 64
+
+/*!
+ * \brief Lock-free single producer, single consumer ring of fixed capacity
+ *
+ * One thread may push() while another thread pops. Neither side ever blocks;
+ * push() fails when the ring is full and pop() fails when it is empty.
+ * Refused pushes are counted in overrunCount().
+ *
+ * Producer and consumer indices live on separate cache lines, and each side
+ * keeps a private copy of the other side's index so it only touches the
+ * shared line when its copy says the ring is full or empty.
+ * The indices run freely and wrap at 2^32, so Capacity must be a power of two.
+ */
+template<typename T, quint32 Capacity>
+class QSPSCQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "QSPSCQueue capacity must be a power of two");
+
+public:
+    bool push(const T &value)
+    {
+        const quint32 tail = m_producer.tail.loadRelaxed();
+
+        if(tail - m_producer.headCache == Capacity)
+        {
+            m_producer.headCache = m_consumer.head.loadAcquire();
+
+            if(tail - m_producer.headCache == Capacity)
+            {
+                m_producer.overruns.storeRelaxed(m_producer.overruns.loadRelaxed() + 1);
+                return false;
+            }
+        }
+
+        m_buffer[tail & (Capacity - 1)] = value;
+        m_producer.tail.storeRelease(tail + 1);
+
+        return true;
+    }
+
+    bool pop(T *value)
+    {
+        return pop(value, 1) == 1;
+    }
+
+    //pops up to maximum values in one go, returns how many were popped
+    quint32 pop(T *values, quint32 maximum)
+    {
+        const quint32 head = m_consumer.head.loadRelaxed();
+
+        if(m_consumer.tailCache - head < maximum)
+            m_consumer.tailCache = m_producer.tail.loadAcquire();
+
+        const quint32 count = qMin(m_consumer.tailCache - head, maximum);
+
+        for(quint32 i = 0; i < count; ++i)
+            values[i] = m_buffer[(head + i) & (Capacity - 1)];
+
+        if(count > 0)
+            m_consumer.head.storeRelease(head + count);
+
+        return count;
+    }
+
+    quint32 count() const
+    {
+        return m_producer.tail.loadAcquire() - m_consumer.head.loadAcquire();
+    }
+
+    bool isEmpty() const
+    {
+        return count() == 0;
+    }
+
+    quint64 overrunCount() const
+    {
+        return m_producer.overruns.loadRelaxed();
+    }
+
+    static constexpr quint32 capacity()
+    {
+        return Capacity;
+    }
+
+private:
+    struct alignas(QSPSCQUEUE_CACHE_LINE) Producer
+    {
+        QAtomicInteger<quint32> tail = 0;
+        quint32 headCache = 0;
+        QAtomicInteger<quint64> overruns = 0;
+    };
+
+    struct alignas(QSPSCQUEUE_CACHE_LINE) Consumer
+    {
+        QAtomicInteger<quint32> head = 0;
+        quint32 tailCache = 0;
+    };
+
+    Producer m_producer;
+    Consumer m_consumer;
+
+    alignas(QSPSCQUEUE_CACHE_LINE) T m_buffer[Capacity];
+};
+
+QT_END_NAMESPACE
+
+#endif // QSPSCQUEUE_H
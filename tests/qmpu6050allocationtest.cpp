@@ -0,0 +1,229 @@
+#include <QCoreApplication>
+#include <QMetaMethod>
+
+#include "qmpu6050acquisition.h"
+#include "qmpu6050emulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <new>
+
+/*
+ * Runs the acquisition engine against the emulator transport and counts the
+ * heap allocations of its steady-state sampling cycles, which must be none.
+ * Global operator new/delete are replaced by counting versions; on glibc
+ * malloc, calloc and realloc are interposed as well, since Qt containers
+ * allocate through them. Only the thread running the cycles is counted.
+ */
+
+#ifdef __GLIBC__
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+#endif
+
+namespace {
+
+thread_local bool counting = false;
+thread_local quint64 allocations = 0;
+
+int failures = 0;
+
+void check(bool condition, const char *description)
+{
+    printf("%s %s\n", condition ? "PASS" : "FAIL", description);
+
+    if(!condition)
+        ++failures;
+}
+
+void *allocate(size_t size)
+{
+    if(counting)
+        ++allocations;
+
+#ifdef __GLIBC__
+    void *pointer = __libc_malloc(size ? size : 1);
+#else
+    void *pointer = malloc(size ? size : 1);
+#endif
+
+    if(!pointer)
+        throw std::bad_alloc();
+
+    return pointer;
+}
+
+}
+
+void *operator new(size_t size)
+{
+    return allocate(size);
+}
+
+void *operator new[](size_t size)
+{
+    return allocate(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept
+{
+    free(pointer);
+}
+
+#ifdef __GLIBC__
+extern "C" void *malloc(size_t size)
+{
+    if(counting)
+        ++allocations;
+
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    if(counting)
+        ++allocations;
+
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size)
+{
+    if(counting)
+        ++allocations;
+
+    return __libc_realloc(pointer, size);
+}
+#endif
+
+namespace {
+
+const quint32 warmUpCycles = 50;
+const quint32 steadyCycles = 200;
+
+struct Listener : QMPU6050FrameListener
+{
+    quint64 frames = 0;
+    quint64 batches = 0;
+
+    virtual void frameReceived(const QMPU6050Frame &frame) override
+    {
+        Q_UNUSED(frame)
+        ++frames;
+    }
+
+    virtual void batchReceived(const QMPU6050Batch &batch) override
+    {
+        Q_UNUSED(batch)
+        ++batches;
+    }
+};
+
+//one poll timer tick, i.e. a sampling cycle followed by dispatch()
+void cycle(QMPU6050Acquisition *acquisition, const QMetaMethod &poll, useconds_t period)
+{
+    usleep(period);
+    poll.invoke(acquisition, Qt::DirectConnection);
+}
+
+void steadyState(QMPU6050Acquisition *acquisition, QMPU6050Acquisition::Mode mode, qreal rate, useconds_t period, const char *description)
+{
+    const QMetaMethod poll = acquisition->metaObject()->method(acquisition->metaObject()->indexOfMethod("poll()"));
+
+    Listener listener;
+    quint64 signalled = 0;
+
+    QMetaObject::Connection connection = QObject::connect(acquisition, &QMPU6050Acquisition::frameReady, acquisition, [&signalled](const QMPU6050Frame &frame)
+    {
+        Q_UNUSED(frame)
+        ++signalled;
+    }, Qt::DirectConnection);
+
+    acquisition->attach(&listener, rate, QMPU6050Acquisition::AllSources, mode);
+
+    //let every buffer reach its working size, one long cycle covers the
+    //largest FIFO batch a late tick can bring
+    for(quint32 i = 0; i < warmUpCycles; ++i)
+        cycle(acquisition, poll, period);
+
+    cycle(acquisition, poll, period * 3);
+
+    quint64 frames = listener.frames;
+
+    allocations = 0;
+    counting = true;
+
+    for(quint32 i = 0; i < steadyCycles; ++i)
+        cycle(acquisition, poll, period);
+
+    counting = false;
+
+    printf("%s: %llu frames, %llu allocations\n", description, static_cast<unsigned long long>(listener.frames - frames), static_cast<unsigned long long>(allocations));
+
+    check(listener.frames > frames && signalled > 0 && listener.batches > 0, "frames reach the listener and the direct connection");
+    check(acquisition->faultState() == QMPU6050Acquisition::HealthyState, "no bus faults");
+    check(allocations == 0, "steady-state cycles do not allocate");
+
+    QObject::disconnect(connection);
+    acquisition->detach(&listener);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+
+    QMPU6050Emulator::registerTransport();
+
+    QMPU6050Acquisition *acquisition = QMPU6050Acquisition::acquire(QStringLiteral("emulator:allocation"), MPU6050_DEFAULT_ADDRESS);
+
+    //the emulated chip comes up asleep
+    QI2CDevice *device = acquisition->device();
+    quint8 power = MPU6050_CLOCK_PLL_XGYRO;
+
+    check(device->start() && device->write(static_cast<quint8>(MPU6050_RA_PWR_MGMT_1), &power, 1), "emulated chip wakes up");
+    device->end();
+
+    steadyState(acquisition, QMPU6050Acquisition::PollingMode, 200, 5000, "polling");
+    steadyState(acquisition, QMPU6050Acquisition::FIFOMode, 1000, 10000, "fifo");
+
+    QMPU6050Acquisition::release(acquisition);
+
+    return failures ? 1 : 0;
+}
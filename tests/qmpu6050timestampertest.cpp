@@ -0,0 +1,147 @@
+#include <QtCore/qglobal.h>
+
+#include "qmpu6050timestamper.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include <random>
+
+/*
+ * Feeds QMPU6050Timestamper with reads of a simulated chip whose oscillator
+ * runs off nominal and checks the reconstructed sample times.
+ */
+
+namespace {
+
+const qreal nominalPeriod = 1000;  //microseconds, 1 kHz
+const quint32 samplesPerRead = 10;
+
+int failures = 0;
+
+void check(bool condition, const char *description)
+{
+    printf("%s %s\n", condition ? "PASS" : "FAIL", description);
+
+    if(!condition)
+        ++failures;
+}
+
+//chip sampling every period microseconds, read every samplesPerRead samples
+//with the read landing anywhere up to one period after the newest sample
+struct Chip
+{
+    qreal period;
+    qreal next;
+    std::mt19937 generator { 6050 };
+    std::uniform_real_distribution<qreal> latency { 0, nominalPeriod };
+
+    Chip(qreal period, qreal start) : period(period), next(start) { }
+
+    //reads the next samplesPerRead samples into \a timestamper, returns the
+    //true time of the newest one
+    qreal read(QMPU6050Timestamper *timestamper, qreal *previousRead)
+    {
+        qreal newest = next + (samplesPerRead - 1) * period;
+        qreal now = newest + latency(generator);
+        qreal earliest = qMax(*previousRead, now - timestamper->period());
+
+        timestamper->update(samplesPerRead, (earliest + now) / 2, static_cast<quint64>(now));
+
+        next = newest + period;
+        *previousRead = now;
+
+        return newest;
+    }
+};
+
+qreal worstError(QMPU6050Timestamper *timestamper, Chip *chip, qreal *previousRead, int reads)
+{
+    qreal worst = 0;
+
+    for(int i = 0; i < reads; ++i)
+    {
+        qreal newest = chip->read(timestamper, previousRead);
+        worst = qMax(worst, fabs(timestamper->timestamp(samplesPerRead - 1) - newest));
+    }
+
+    return worst;
+}
+
+void tracksDrift()
+{
+    //oscillator 2000 ppm slow
+    QMPU6050Timestamper timestamper;
+    timestamper.setNominalPeriod(nominalPeriod);
+
+    Chip chip(nominalPeriod * 1.002, 1e6);
+    qreal previousRead = 0;
+
+    worstError(&timestamper, &chip, &previousRead, 200);
+    qreal error = worstError(&timestamper, &chip, &previousRead, 500);
+
+    check(error < nominalPeriod / 2, "locked sample times stay within half a period");
+    check(fabs(timestamper.drift() + 2000) < 300, "drift estimate within 300 ppm of -2000 ppm");
+    check(timestamper.resyncCount() == 0, "no resynchronization on a continuous stream");
+}
+
+void resyncTakesNewPhase()
+{
+    QMPU6050Timestamper timestamper;
+    timestamper.setNominalPeriod(nominalPeriod);
+
+    Chip chip(nominalPeriod, 1e6);
+    qreal previousRead = 0;
+
+    worstError(&timestamper, &chip, &previousRead, 200);
+
+    //the FIFO restarted: the next sample comes 3.5 periods off the old grid,
+    //within resyncThreshold, so only an explicit resync drops the old phase
+    chip.next += 3.5 * nominalPeriod;
+    timestamper.resync();
+
+    qreal newest = chip.read(&timestamper, &previousRead);
+
+    check(timestamper.resyncCount() == 1, "resync() is counted once");
+    check(fabs(timestamper.timestamp(samplesPerRead - 1) - newest) < nominalPeriod, "first read after resync() is timed from the new phase");
+    check(fabs(timestamper.period() - nominalPeriod) < 10, "resync() keeps the period estimate");
+}
+
+void timesIncrease()
+{
+    QMPU6050Timestamper timestamper;
+    timestamper.setNominalPeriod(nominalPeriod);
+
+    Chip chip(nominalPeriod * 0.999, 1e6);
+    qreal previousRead = 0;
+    quint64 previous = 0;
+    bool increasing = true;
+
+    for(int i = 0; i < 300; ++i)
+    {
+        chip.read(&timestamper, &previousRead);
+
+        for(quint32 sample = 0; sample < samplesPerRead; ++sample)
+        {
+            quint64 time = timestamper.timestamp(sample);
+            increasing = increasing && time > previous;
+            previous = time;
+        }
+
+        if(i == 150)
+            timestamper.resync();
+    }
+
+    check(increasing, "sample times always increase, across resync() as well");
+}
+
+}
+
+int main()
+{
+    tracksDrift();
+    resyncTakesNewPhase();
+    timesIncrease();
+
+    return failures ? 1 : 0;
+}